@@ -0,0 +1,49 @@
+/** allocation_counter.cpp **/
+
+#include <iostream>
+#include <cstdlib>
+#include <new>
+#include <atomic>
+#include "allocation_counter.hpp"
+
+#ifdef COUNT_ALLOCATIONS
+	std::atomic<unsigned long> allocation_count(0);
+
+	void *operator new(size_t size) {
+		allocation_count.fetch_add(1, std::memory_order_relaxed);
+		void *p = malloc(size ? size : 1);
+		if(!p) throw std::bad_alloc();
+		return p;
+	}
+	void *operator new[](size_t size) {
+		return operator new(size);
+	}
+	void operator delete(void *p) noexcept {
+		free(p);
+	}
+	void operator delete[](void *p) noexcept {
+		free(p);
+	}
+
+	unsigned long get_allocation_count() {
+		return allocation_count.load(std::memory_order_relaxed);
+	}
+
+	//Fails if the frame that just ended allocated something after the warmup
+	void allocation_checker_c::end_frame() {
+		const unsigned long count = get_allocation_count();
+		frame++;
+		if(frame > ALLOCATION_WARMUP_FRAMES && count != previous_count) {
+			std::cerr << "ERROR: Frame " << frame << " did " << count - previous_count << " heap allocations!" << std::endl;
+			exit(1);
+		}
+		if(frame == ALLOCATION_WARMUP_FRAMES) std::cout << "Allocations during warmup: " << count << std::endl;
+		previous_count = count;
+	}
+#else
+	unsigned long get_allocation_count() {
+		return 0;
+	}
+
+	void allocation_checker_c::end_frame() {}
+#endif
@@ -0,0 +1,28 @@
+/** allocation_counter.hpp **/
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+/*
+	When compiled with COUNT_ALLOCATIONS (make COUNT_ALLOCATIONS=1)
+	  every allocation done with new is counted
+	  and the program fails if a frame allocates anything after the first frames
+	Otherwise these do nothing
+*/
+
+//The amount of frames that may still allocate, for example for lazy initialization in the libraries
+#define ALLOCATION_WARMUP_FRAMES 60
+
+unsigned long get_allocation_count();
+
+class allocation_checker_c {
+	private:
+		unsigned long previous_count;
+		int frame;
+
+	public:
+		allocation_checker_c(): previous_count(get_allocation_count()), frame(0) {}
+		void end_frame();
+};
+
+#endif
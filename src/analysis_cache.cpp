@@ -0,0 +1,221 @@
+/** analysis_cache.cpp **/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include "analysis_cache.hpp"
+#include "analyzer.hpp"
+#include "main.hpp"
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <direct.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+#define CACHE_DIRECTORY "cache"
+#define CACHE_VERSION 1
+
+//The largest values that can be stored, larger values are clamped
+#define MAX_SUM 32.0f
+#define MAX_BAR 4.0f
+
+//A record is a valid flag, the four sums and then the bars
+#define SUM_AMOUNT 4
+#define RECORD_HEADER_SIZE (2 + SUM_AMOUNT * 2)
+
+struct cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t frame_count;
+	uint32_t bar_amount;
+	uint32_t record_size;
+	uint64_t key;
+};
+
+//A fast hash that processes 8 bytes at a time
+inline uint64_t hash_mix(uint64_t h, const uint64_t value) {
+	h^= value;
+	h*= 0x9E3779B97F4A7C15ULL;
+	return h ^ (h >> 29);
+}
+
+//Hashes the contents of a file
+uint64_t hash_file(const char *path) {
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	uint64_t h = 0xCBF29CE484222325ULL;
+	uint64_t buffer[8192];
+	while(file.good()) {
+		file.read((char*)buffer, sizeof(buffer));
+		const size_t bytes = file.gcount();
+		for(size_t i = 0; i < bytes / 8; i++) h = hash_mix(h, buffer[i]);
+		uint64_t tail = 0;
+		memcpy(&tail, (char*)buffer + bytes / 8 * 8, bytes % 8);
+		h = hash_mix(h, tail ^ bytes);
+	}
+	return h;
+}
+
+//The key changes whenever the song or anything affecting the analysis results changes
+uint64_t cache_key(const char *song_name, const analyzer_settings &settings, const int bar_amount) {
+	uint64_t h = hash_file(song_name);
+	h = hash_mix(h, CACHE_VERSION);
+	h = hash_mix(h, OUTPUTRATE);
+	h = hash_mix(h, SPECTRUMSIZE);
+	h = hash_mix(h, (uint64_t)(BAR_MULT * 1000000.0));
+	h = hash_mix(h, SPECTRUM_START);
+	h = hash_mix(h, SPECTRUM_END);
+	h = hash_mix(h, settings.bar_type);
+	h = hash_mix(h, BAR_SCALE);
+	h = hash_mix(h, BAR_AMOUNT);
+	if(settings.smooth_spectrum) h = hash_mix(h, 1);
+	if(settings.smooth_bars) h = hash_mix(h, 2);
+	#ifdef FMOD_SPECTRUM
+		h = hash_mix(h, 3);
+	#endif
+	h = hash_mix(h, (uint64_t)(FPS * 1000.0));
+	h = hash_mix(h, bar_amount);
+	return h;
+}
+
+inline uint16_t quantize_sum(const float value) {
+	return std::min(std::max(value / MAX_SUM, 0.0f), 1.0f) * 65535.0f + 0.5f;
+}
+inline float dequantize_sum(const uint16_t value) {
+	return value / 65535.0f * MAX_SUM;
+}
+inline unsigned char quantize_bar(const float value) {
+	return sqrt(std::min(std::max(value / MAX_BAR, 0.0f), 1.0f)) * 255.0f + 0.5f;
+}
+inline float dequantize_bar(const unsigned char value) {
+	const float v = value / 255.0f;
+	return v * v * MAX_BAR;
+}
+
+analysis_cache_c::analysis_cache_c(const char *song_name, const unsigned int length_ms, const analyzer_settings &settings, const int bar_amount):
+	bar_amount(bar_amount),
+	frame_count(length_ms * FPS / 1000.0 + 1),
+	record_size(RECORD_HEADER_SIZE + bar_amount),
+	data(NULL), data_size(0) {
+
+	#ifdef _WIN32
+		file = INVALID_HANDLE_VALUE;
+		mapping = NULL;
+		_mkdir(CACHE_DIRECTORY);
+	#else
+		file = -1;
+		mkdir(CACHE_DIRECTORY, 0755);
+	#endif
+
+	const uint64_t key = cache_key(song_name, settings, bar_amount);
+	std::ostringstream path;
+	path << CACHE_DIRECTORY << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".cache";
+	if(!open(path.str().c_str(), key)) std::cerr << "Couldn't open the analysis cache " << path.str() << std::endl;
+}
+
+analysis_cache_c::~analysis_cache_c() {
+	close();
+}
+
+//Maps the cache file to memory and creates it if it doesn't exist or has wrong parameters
+bool analysis_cache_c::open(const char *path, const uint64_t key) {
+	data_size = sizeof(cache_header) + frame_count * record_size;
+
+	#ifdef _WIN32
+		file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(file == INVALID_HANDLE_VALUE) return false;
+		LARGE_INTEGER size;
+		const bool existing = GetFileSizeEx(file, &size) && size.QuadPart == data_size;
+		mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, data_size, NULL);
+		if(!mapping) return false;
+		data = (unsigned char*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, data_size);
+		if(!data) return false;
+	#else
+		file = ::open(path, O_RDWR | O_CREAT, 0644);
+		if(file < 0) return false;
+		struct stat info;
+		const bool existing = fstat(file, &info) == 0 && info.st_size == (off_t)data_size;
+		if(!existing && ftruncate(file, data_size) != 0) return false;
+		void *mapped = mmap(NULL, data_size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+		if(mapped == MAP_FAILED) return false;
+		data = (unsigned char*)mapped;
+	#endif
+
+	//Start from scratch if the file is not what we expect
+	cache_header *header = (cache_header*)data;
+	if(!existing
+	|| memcmp(header->magic, "VISCACHE", 8) != 0
+	|| header->version != CACHE_VERSION
+	|| header->frame_count != frame_count
+	|| header->bar_amount != (uint32_t)bar_amount
+	|| header->record_size != record_size
+	|| header->key != key) {
+		memset(data, 0, data_size);
+		memcpy(header->magic, "VISCACHE", 8);
+		header->version = CACHE_VERSION;
+		header->frame_count = frame_count;
+		header->bar_amount = bar_amount;
+		header->record_size = record_size;
+		header->key = key;
+	}
+	return true;
+}
+
+void analysis_cache_c::close() {
+	#ifdef _WIN32
+		if(data) UnmapViewOfFile(data);
+		if(mapping) CloseHandle(mapping);
+		if(file != INVALID_HANDLE_VALUE) CloseHandle(file);
+		mapping = NULL;
+		file = INVALID_HANDLE_VALUE;
+	#else
+		if(data) munmap(data, data_size);
+		if(file >= 0) ::close(file);
+		file = -1;
+	#endif
+	data = NULL;
+}
+
+//Returns the record of the frame that is played at the given time
+unsigned char *analysis_cache_c::get_record(const unsigned int position_ms) const {
+	const unsigned int frame = position_ms * FPS / 1000.0;
+	if(!data || frame >= frame_count) return NULL;
+	return data + sizeof(cache_header) + frame * record_size;
+}
+
+//Reads the results of the frame at the given time straight from the mapped file
+//Returns false if the frame hasn't been stored yet
+//sums are bass, left, right and sound
+bool analysis_cache_c::lookup(const unsigned int position_ms, float *bar_heights, float *sums) const {
+	const unsigned char *record = get_record(position_ms);
+	if(!record || !record[0]) return false;
+
+	uint16_t quantized_sums[SUM_AMOUNT];
+	memcpy(quantized_sums, record + 2, sizeof(quantized_sums));
+	for(int i = 0; i < SUM_AMOUNT; i++) sums[i] = dequantize_sum(quantized_sums[i]);
+	const unsigned char *bars = record + RECORD_HEADER_SIZE;
+	for(int i = 0; i < bar_amount; i++) bar_heights[i] = dequantize_bar(bars[i]);
+	return true;
+}
+
+//Stores the results of the frame at the given time
+//The valid flag is set last so that a partially written record is never used
+void analysis_cache_c::store(const unsigned int position_ms, const float *bar_heights, const float *sums) {
+	unsigned char *record = get_record(position_ms);
+	if(!record) return;
+
+	uint16_t quantized_sums[SUM_AMOUNT];
+	for(int i = 0; i < SUM_AMOUNT; i++) quantized_sums[i] = quantize_sum(sums[i]);
+	memcpy(record + 2, quantized_sums, sizeof(quantized_sums));
+	unsigned char *bars = record + RECORD_HEADER_SIZE;
+	for(int i = 0; i < bar_amount; i++) bars[i] = quantize_bar(bar_heights[i]);
+	record[0] = 1;
+}
@@ -0,0 +1,50 @@
+/** analysis_cache.hpp **/
+
+#ifndef ANALYSIS_CACHE_HPP
+#define ANALYSIS_CACHE_HPP
+
+#include <stdint.h>
+
+struct analyzer_settings;
+
+/*
+	A persistent cache for the analysis results of every frame of a song
+	The cache file is memory mapped and indexed by the playback time,
+	  so when a song is played again or it loops the results can be read without analyzing anything
+	The file is named after a hash of the contents of the song and the analysis parameters
+	  so changing either of them just creates a new file
+
+	To keep the files small the values are quantized:
+	  the sums use 16 bits and the bars use 8 bits on a square root scale
+	  which is about 300 bytes per frame or 4 MB for a 4 minute song
+*/
+class analysis_cache_c {
+	private:
+		analysis_cache_c(const analysis_cache_c &obj); //Copy constructor
+		analysis_cache_c &operator=(const analysis_cache_c &obj); //Assign operator
+
+		const int bar_amount;
+		unsigned int frame_count;
+		unsigned int record_size;
+		unsigned char *data; //The memory mapped file, NULL if the cache couldn't be opened
+		unsigned int data_size;
+		#ifdef _WIN32
+			void *file, *mapping;
+		#else
+			int file;
+		#endif
+
+		bool open(const char *path, const uint64_t key);
+		void close();
+		unsigned char *get_record(const unsigned int position_ms) const;
+
+	public:
+		analysis_cache_c(const char *song_name, const unsigned int length_ms, const analyzer_settings &settings, const int bar_amount);
+		~analysis_cache_c();
+
+		bool is_open() const { return data != NULL; }
+		bool lookup(const unsigned int position_ms, float *bar_heights, float *sums) const;
+		void store(const unsigned int position_ms, const float *bar_heights, const float *sums);
+};
+
+#endif
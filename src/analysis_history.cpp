@@ -0,0 +1,36 @@
+/** analysis_history.cpp **/
+
+#include "analysis_history.hpp"
+
+//The memory of all the frames is allocated here
+analysis_history_c::analysis_history_c(const analyzer_c &analyzer): newest(0), amount(0) {
+	const analysis_frame empty_frame(analyzer);
+	for(int i = 0; i < ANALYSIS_HISTORY; i++) frames[i] = empty_frame;
+}
+
+//Copies the frame over the oldest one, the frames must come in the order they were analyzed
+void analysis_history_c::push(const analysis_frame &frame) {
+	newest = (newest + 1) % ANALYSIS_HISTORY;
+	frames[newest] = frame;
+	if(amount < ANALYSIS_HISTORY) amount++;
+}
+
+//Sets result to what was heard at audible_time
+//Before the oldest frame the oldest one is used and after the newest the newest one is used
+void analysis_history_c::get(const double audible_time, analysis_frame &result) const {
+	if(amount == 0) return;
+	if(audible_time >= frames[newest].audible_time) {
+		result = frames[newest];
+		return;
+	}
+	for(int i = 0; i < amount - 1; i++) {
+		const analysis_frame &newer = frames[(newest - i + ANALYSIS_HISTORY) % ANALYSIS_HISTORY];
+		const analysis_frame &older = frames[(newest - i - 1 + ANALYSIS_HISTORY) % ANALYSIS_HISTORY];
+		if(audible_time >= older.audible_time) {
+			const double span = newer.audible_time - older.audible_time;
+			result.interpolate(older, newer, span > 0.0 ? (audible_time - older.audible_time) / span : 1.0);
+			return;
+		}
+	}
+	result = frames[(newest - amount + 1 + ANALYSIS_HISTORY) % ANALYSIS_HISTORY];
+}
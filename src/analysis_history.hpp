@@ -0,0 +1,33 @@
+/** analysis_history.hpp **/
+
+#ifndef ANALYSIS_HISTORY_HPP
+#define ANALYSIS_HISTORY_HPP
+
+#include "analysis_thread.hpp"
+
+//The amount of the latest analysis frames that are kept, about 0.13 seconds at 60 frames per second
+#define ANALYSIS_HISTORY 8
+
+/*
+	The latest results of the analysis thread on the side of the render thread
+	Every frame knows when its sound is heard, so the frame that matches the moment
+	  when a drawn frame reaches the screen can be picked from here
+	Between two frames the results are interpolated and the newest frame is used
+	  when the sound of the moment hasn't been analyzed yet
+*/
+class analysis_history_c {
+	private:
+		analysis_history_c(const analysis_history_c &obj); //Copy constructor
+		analysis_history_c &operator=(const analysis_history_c &obj); //Assign operator
+
+		analysis_frame frames[ANALYSIS_HISTORY];
+		int newest; //The index of the newest frame
+		int amount;
+
+	public:
+		analysis_history_c(const analyzer_c &analyzer);
+		void push(const analysis_frame &frame);
+		void get(const double audible_time, analysis_frame &result) const;
+};
+
+#endif
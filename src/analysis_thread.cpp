@@ -0,0 +1,92 @@
+/** analysis_thread.cpp **/
+
+#include <algorithm>
+#include "analysis_thread.hpp"
+#include "main.hpp"
+#include "clock.hpp"
+#include "frame_pacer.hpp"
+#include "profiler.hpp"
+
+//Allocates the memory for the results of the analyzer
+analysis_frame::analysis_frame(const analyzer_c &analyzer):
+	bar_heights(analyzer.get_settings().gpu_bars ? 0 : analyzer.get_bar_amount(), 0.0f),
+	spectrum(analyzer.get_settings().gpu_bars ? SPECTRUMSIZE : 0, 0.0f),
+	bass_sum(0), left_sum(0), right_sum(0), sound_sum(0), position_ms(0), window_position(0), audible_time(0) {}
+
+//Copies the latest results of the analyzer and when the analyzed sound is heard
+void analysis_frame::capture(const analyzer_c &analyzer, const sound_system_c &sound_system) {
+	if(!bar_heights.empty()) std::copy(analyzer.get_bar_heights(), analyzer.get_bar_heights() + bar_heights.size(), bar_heights.begin());
+	if(!spectrum.empty()) {
+		const float *spectrumL = analyzer.get_spectrum_left();
+		const float *spectrumR = analyzer.get_spectrum_right();
+		for(int i = 0; i < SPECTRUMSIZE; i++) spectrum[i] = spectrumL[i] + spectrumR[i];
+	}
+	bass_sum = analyzer.get_bass_sum();
+	left_sum = analyzer.get_left_sum();
+	right_sum = analyzer.get_right_sum();
+	sound_sum = analyzer.get_sound_sum();
+	position_ms = sound_system.get_position_ms();
+	window_position = sound_system.get_window_position();
+	audible_time = get_time() + sound_system.get_window_delay();
+	sound_system.get_status(sound);
+}
+
+//Sets this between the frames a and b, t = 0 is a and t = 1 is b
+//All the frames must come from the same analyzer
+void analysis_frame::interpolate(const analysis_frame &a, const analysis_frame &b, const float t) {
+	for(size_t i = 0; i < bar_heights.size(); i++) bar_heights[i] = a.bar_heights[i] + (b.bar_heights[i] - a.bar_heights[i]) * t;
+	for(size_t i = 0; i < spectrum.size(); i++) spectrum[i] = a.spectrum[i] + (b.spectrum[i] - a.spectrum[i]) * t;
+	bass_sum = a.bass_sum + (b.bass_sum - a.bass_sum) * t;
+	left_sum = a.left_sum + (b.left_sum - a.left_sum) * t;
+	right_sum = a.right_sum + (b.right_sum - a.right_sum) * t;
+	sound_sum = a.sound_sum + (b.sound_sum - a.sound_sum) * t;
+	position_ms = t < 0.5f ? a.position_ms : b.position_ms;
+	window_position = t < 0.5f ? a.window_position : b.window_position;
+	audible_time = a.audible_time + (b.audible_time - a.audible_time) * t;
+	sound = t < 0.5f ? a.sound : b.sound;
+}
+
+analysis_thread_c::analysis_thread_c(sound_system_c &sound_system, analyzer_c &analyzer):
+	sound_system(sound_system), analyzer(analyzer), results(analysis_frame(analyzer)), running(false), analysis_time(0), frames(0) {}
+
+analysis_thread_c::~analysis_thread_c() {
+	stop();
+}
+
+void analysis_thread_c::start() {
+	if(running) return;
+	running = true;
+	thread = std::thread(&analysis_thread_c::run, this);
+}
+
+//Waits for the current analysis to finish
+void analysis_thread_c::stop() {
+	running = false;
+	if(thread.joinable()) thread.join();
+}
+
+//The loop of the thread
+void analysis_thread_c::run() {
+	//The smoothing and the cache are made for FPS frames per second whatever the rate of the drawing is
+	tracer.set_thread_name("analysis");
+	frame_pacer_c pacer(FPS);
+	pacer.start();
+	while(running) {
+		{
+			scoped_timer_c timer(STAGE_SOUND_UPDATE);
+			sound_system.update();
+		}
+
+		const double analysis_start_time = get_time();
+		analyzer.analyze(sound_system);
+		analysis_time+= get_time() - analysis_start_time;
+		frames++;
+
+		results.get_back().capture(analyzer, sound_system);
+		results.publish();
+
+		//Handle frames per second
+		pacer.end_frame();
+		pacer.wait();
+	}
+}
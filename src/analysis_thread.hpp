@@ -0,0 +1,63 @@
+/** analysis_thread.hpp **/
+
+#ifndef ANALYSIS_THREAD_HPP
+#define ANALYSIS_THREAD_HPP
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "analyzer.hpp"
+#include "triple_buffer.hpp"
+
+//The results of the analysis of one frame, everything that the drawing needs from it
+struct analysis_frame {
+	std::vector<float> bar_heights; //Empty when the GPU calculates the bars
+	std::vector<float> spectrum; //Both channels summed, only for the GPU bars
+	float bass_sum, left_sum, right_sum, sound_sum;
+	unsigned int position_ms; //The position of the analyzed sound in the song
+	unsigned int window_position; //The middle of the analysis window in the PCM samples of the song
+	double audible_time; //When the middle of the analysis window is heard on the clock of clock.hpp
+	sound_status sound; //For the hitch recorder
+
+	analysis_frame(): bass_sum(0), left_sum(0), right_sum(0), sound_sum(0), position_ms(0), window_position(0), audible_time(0) {}
+	analysis_frame(const analyzer_c &analyzer);
+	void capture(const analyzer_c &analyzer, const sound_system_c &sound_system);
+	void interpolate(const analysis_frame &a, const analysis_frame &b, const float t);
+};
+
+/*
+	Runs the analysis of the music in its own thread while the music is played in realtime
+	The thread updates FMOD and analyzes the music FPS times per second
+	  and publishes the results through a triple buffer that the render thread reads when it likes,
+	  so a slow swap doesn't delay the analysis and a slow FMOD call doesn't delay the drawing
+	The render thread must not use the sound system or the analyzer while the thread is running
+*/
+class analysis_thread_c {
+	private:
+		analysis_thread_c(const analysis_thread_c &obj); //Copy constructor
+		analysis_thread_c &operator=(const analysis_thread_c &obj); //Assign operator
+
+		sound_system_c &sound_system;
+		analyzer_c &analyzer;
+		triple_buffer_c<analysis_frame> results;
+		std::thread thread;
+		std::atomic<bool> running;
+
+		//Only read after the thread has stopped
+		double analysis_time;
+		int frames;
+
+		void run();
+
+	public:
+		analysis_thread_c(sound_system_c &sound_system, analyzer_c &analyzer);
+		~analysis_thread_c();
+		void start();
+		void stop();
+		bool update() { return results.update(); }
+		const analysis_frame &get_frame() const { return results.get_front(); }
+		double get_analysis_time() const { return analysis_time; }
+		int get_frames() const { return frames; }
+};
+
+#endif
@@ -0,0 +1,203 @@
+/** analyzer.cpp **/
+
+#include <cmath>
+#include <algorithm>
+#include "analyzer.hpp"
+#include "simd.hpp"
+#include "profiler.hpp"
+
+//Rather useless defines
+#define SPECTRUMRANGE ((float)OUTPUTRATE / 2.0f) // 24000.0 Hz
+#define BINSIZE (SPECTRUMRANGE / (float)SPECTRUMSIZE) // 5.8594 Hz
+
+analyzer_c::analyzer_c(const analyzer_settings &settings):
+	spectrum_kernel(SPECTRUMSIZE, SPECTRUM_START, SPECTRUM_END),
+	bar_matrix(SPECTRUMSIZE), bar_sumL(NULL), bar_sumR(NULL),
+	bass_sum(0), left_sum(0), right_sum(0), sound_sum(0), cache(NULL),
+	//The padded raw spectrums and the unsmoothed bars
+	arena(sizeof(float) * ((SPECTRUMSIZE + SPECTRUM_PADDING * 2) * 2 + SPECTRUMSIZE) + SIMD_ALIGNMENT * 3),
+	settings(settings), analyze_spectrum(choose_kernel(settings)) {
+
+	//Bars 1 have constant width
+	//This figures out how to combine or divide the bars on the linear scale
+	//  so that they use logarithmic scale instead
+	if(settings.bar_type == 1) {
+		if(BAR_SCALE == SCALE_LOG) bar_amount = generate_log_bars(bar_matrix, BAR_MULT, SPECTRUM_START, SPECTRUM_END);
+		else bar_amount = generate_scale_bars(bar_matrix, BAR_SCALE, BAR_AMOUNT, SPECTRUM_START, SPECTRUM_END, BINSIZE);
+		bar_sumL = new float[bar_amount];
+		bar_sumR = new float[bar_amount];
+
+		bar_positions = new float[bar_amount + 1];
+		for(int j = 0; j <= bar_amount; j++) bar_positions[j] = -1.0 + (float)j / (float)bar_amount * 2.0;
+	}
+
+	//Bars 2 have variable width
+	//This figures widths for the bars so that are on a logarithmic scale
+	else {
+		float total_size = 0;
+		for(int i = 0; i < SPECTRUMSIZE - 1; i++) {
+			bar_size[i] = log(i + 2) - log(i + 1);
+			if(i >= SPECTRUM_START && i < SPECTRUM_END) total_size+= bar_size[i];
+		}
+		for(int i = 0; i < SPECTRUMSIZE - 1; i++) bar_size[i]*= 2.0 / total_size;
+
+		bar_amount = SPECTRUM_END - SPECTRUM_START;
+		bar_positions = new float[bar_amount + 1];
+		bar_positions[0] = -1;
+		for(int i = 0; i < bar_amount; i++) bar_positions[i + 1] = bar_positions[i] + bar_size[SPECTRUM_START + i];
+	}
+
+	bar_heights = new float[bar_amount];
+	for(int i = 0; i < bar_amount; i++) bar_heights[i] = 0;
+}
+
+analyzer_c::~analyzer_c() {
+	delete [] bar_sumL;
+	delete [] bar_sumR;
+	delete [] bar_positions;
+	delete [] bar_heights;
+}
+
+//The results are read from the cache when the same part of the song has been analyzed before
+void analyzer_c::set_cache(analysis_cache_c *cache) {
+	this->cache = cache;
+}
+
+//Analyzes the current spectrum of the music
+//samples is the amount of new samples to take to the analysis, 0 takes all of them
+void analyzer_c::analyze(sound_system_c &sound_system, const unsigned int samples) {
+	scoped_timer_c timer(STAGE_ANALYSIS);
+	arena.reset();
+	sound_system.advance(samples);
+	if(!cache || !cache->is_open()) {
+		(this->*analyze_spectrum)(sound_system);
+		return;
+	}
+
+	float sums[4];
+	const unsigned int position = sound_system.get_position_ms();
+	if(cache->lookup(position, bar_heights, sums)) {
+		bass_sum = sums[0];
+		left_sum = sums[1];
+		right_sum = sums[2];
+		sound_sum = sums[3];
+	}
+	else {
+		(this->*analyze_spectrum)(sound_system);
+		sums[0] = bass_sum;
+		sums[1] = left_sum;
+		sums[2] = right_sum;
+		sums[3] = sound_sum;
+		cache->store(position, bar_heights, sums);
+	}
+}
+
+/*
+	The bar calculations
+	calculate turns the smoothed spectrum of the analyzer into its bar heights
+*/
+
+//Bars with constant width
+template<bool SMOOTH>
+struct constant_width_bars {
+	static void calculate(analyzer_c &analyzer) {
+		const int bar_amount = analyzer.bar_amount;
+		float *bar_heights = analyzer.bar_heights;
+		float *bar1_heights = SMOOTH ? analyzer.arena.allocate_floats(bar_amount) : bar_heights;
+
+		//Calculate the heights for the bars
+		analyzer.bar_matrix.apply(analyzer.spectrumL, analyzer.spectrumR, analyzer.bar_sumL, analyzer.bar_sumR);
+		for(int i = 0; i < bar_amount; i++) {
+			bar1_heights[i] = std::max((analyzer.bar_sumL[i] + analyzer.bar_sumR[i]) * 5.0 - 0.04, 0.0) + 0.015;
+		}
+
+		//Smooth the bars here
+		if(SMOOTH) {
+			for(int i = 0; i < bar_amount; i++) {
+				bar_heights[i]
+					= 0.038 * (bar1_heights[std::max(i - 2, 0)] + bar1_heights[std::min(i + 2, bar_amount - 1)])
+					+ 0.154 * (bar1_heights[std::max(i - 1, 0)] + bar1_heights[std::min(i + 1, bar_amount - 1)])
+					+ 0.615 * bar1_heights[i];
+			}
+		}
+	}
+};
+
+//Bars with variable width
+template<bool SMOOTH>
+struct variable_width_bars {
+	static void calculate(analyzer_c &analyzer) {
+		const float *spectrumL = analyzer.spectrumL;
+		const float *spectrumR = analyzer.spectrumR;
+		for(int i = SPECTRUM_START; i < SPECTRUM_END; i++) {
+			//Smooth the bars first
+			if(SMOOTH) {
+				analyzer.bar_heights[i - SPECTRUM_START] = std::max((
+					  (0.038 * (spectrumL[i - 2] + spectrumL[i + 2])
+						+ 0.154 * (spectrumL[i - 1] + spectrumL[i + 1])
+						+ 0.615 * spectrumL[i])
+					+ (0.038 * (spectrumR[i - 2] + spectrumR[i + 2])
+						+ 0.154 * (spectrumR[i - 1] + spectrumR[i + 1])
+						+ 0.615 * spectrumR[i])
+					) / analyzer.bar_size[i] * 0.05 - 0.04, 0.0) + 0.015;
+			}
+			else {
+				analyzer.bar_heights[i - SPECTRUM_START] = std::max((spectrumL[i] + spectrumR[i]) / analyzer.bar_size[i] * 0.05 - 0.04, 0.0) + 0.015;
+			}
+		}
+	}
+};
+
+//The bars are calculated elsewhere from the spectrum
+struct no_bars {
+	static void calculate(analyzer_c &analyzer) {}
+};
+
+//The actual analysis
+template<class BARS, bool SMOOTH_SPECTRUM>
+void analyzer_c::analyze_frame(sound_system_c &sound_system) {
+	//Get spectrum
+	float *raw_spectrumL = arena.allocate_floats(SPECTRUMSIZE + SPECTRUM_PADDING * 2);
+	float *raw_spectrumR = arena.allocate_floats(SPECTRUMSIZE + SPECTRUM_PADDING * 2);
+	for(int i = 0; i < SPECTRUM_PADDING; i++) {
+		raw_spectrumL[i] = raw_spectrumL[SPECTRUMSIZE + SPECTRUM_PADDING + i] = 0.0f;
+		raw_spectrumR[i] = raw_spectrumR[SPECTRUMSIZE + SPECTRUM_PADDING + i] = 0.0f;
+	}
+	raw_spectrumL+= SPECTRUM_PADDING;
+	raw_spectrumR+= SPECTRUM_PADDING;
+	{
+		scoped_timer_c timer(STAGE_FETCH);
+		sound_system.get_spectrum(raw_spectrumL, raw_spectrumR);
+	}
+
+	//Smooth the actual spectrum and calculate the sizes for the squares in one go
+	spectrum_sums sums;
+	{
+		scoped_timer_c timer(STAGE_SMOOTHING);
+		spectrum_kernel.run<SMOOTH_SPECTRUM>(raw_spectrumL, raw_spectrumR, spectrumL, spectrumR, sums);
+	}
+	bass_sum = sums.bass / 150.0;
+	left_sum = sums.left / 800.0;
+	right_sum = sums.right / 800.0;
+	sound_sum = sums.sound;
+
+	//Next calculate the bars
+	scoped_timer_c timer(STAGE_BARS);
+	BARS::calculate(*this);
+}
+
+//Picks the instance of the frame analysis for the settings
+analyzer_c::frame_kernel analyzer_c::choose_kernel(const analyzer_settings &settings) {
+	if(settings.gpu_bars) {
+		if(settings.smooth_spectrum) return &analyzer_c::analyze_frame<no_bars, true>;
+		return &analyzer_c::analyze_frame<no_bars, false>;
+	}
+
+	//Indexed with bar type, spectrum smoothing and bar smoothing
+	static const frame_kernel kernels[2][2][2] = {
+		{{&analyzer_c::analyze_frame<constant_width_bars<false>, false>, &analyzer_c::analyze_frame<constant_width_bars<true>, false>},
+		 {&analyzer_c::analyze_frame<constant_width_bars<false>, true>, &analyzer_c::analyze_frame<constant_width_bars<true>, true>}},
+		{{&analyzer_c::analyze_frame<variable_width_bars<false>, false>, &analyzer_c::analyze_frame<variable_width_bars<true>, false>},
+		 {&analyzer_c::analyze_frame<variable_width_bars<false>, true>, &analyzer_c::analyze_frame<variable_width_bars<true>, true>}}};
+	return kernels[settings.bar_type == 2][settings.smooth_spectrum][settings.smooth_bars];
+}
@@ -0,0 +1,117 @@
+/** analyzer.hpp **/
+
+#ifndef ANALYZER_HPP
+#define ANALYZER_HPP
+
+#include "sound_system.hpp"
+#include "analysis_cache.hpp"
+#include "rebin.hpp"
+#include "frame_arena.hpp"
+#include "spectrum_kernel.hpp"
+
+//The default settings of the analysis, all of these can be changed from the command line
+//Defines the way the bars are drawn
+//in type 1 multiple bars are combined into one or one bar is broken into multiple bars so that all the drawn parts have same width
+//in type 2 all the existing bars are drawn with a variable width
+#define BAR_TYPE 1
+
+#define SMOOTH_SPEC true //Does some smoothing to the spectrum itself
+#define SMOOTH_BARS true //Does some smoothing to the bars, does basically the same as SMOOTH_SPEC when BAR_TYPE is 2
+#define GPU_BARS false //Leaves the bars to the vertex shader (see gpu_bars.hpp)
+
+//The frequency scale of the bars when BAR_TYPE is 1
+//SCALE_LOG is the original scale, the others are SCALE_MEL, SCALE_BARK and SCALE_ERB
+#define BAR_SCALE SCALE_LOG
+#define BAR_MULT 1.022 //Affects the amount of bars with SCALE_LOG
+#define BAR_AMOUNT 270 //The amount of bars with the other scales
+
+//We do not show the full spectrum, instead just the interesting part
+#define SPECTRUM_START 6 // 41.0156 Hz  (7 * BINSIZE)
+#define SPECTRUM_END 2560 // 15000.0 Hz  (2560 * BINSIZE)
+
+//The variant of the analysis that is used
+struct analyzer_settings {
+	int bar_type;
+	bool smooth_spectrum;
+	bool smooth_bars;
+	bool gpu_bars; //The bar heights are not calculated at all
+	analyzer_settings(): bar_type(BAR_TYPE), smooth_spectrum(SMOOTH_SPEC), smooth_bars(SMOOTH_BARS), gpu_bars(GPU_BARS) {}
+};
+
+//The bar calculations, defined in analyzer.cpp
+template<bool SMOOTH> struct constant_width_bars;
+template<bool SMOOTH> struct variable_width_bars;
+struct no_bars;
+
+/*
+	This class turns the spectrum of the music into the sizes of the drawn things
+	First figures out how to draw the bars using logarithmic scale as the spectrum is in linear scale
+	Then analyze is called once per frame
+	Every combination of the settings is its own template instance of the frame analysis
+	  so the settings are chosen once in the constructor and don't cost anything per frame
+	There is no drawing here so this can also be used without a window
+*/
+class analyzer_c {
+	private:
+		analyzer_c(const analyzer_c &obj); //Copy constructor
+		analyzer_c &operator=(const analyzer_c &obj); //Assign operator
+
+		//Storages for the left and right spectrums
+		float spectrumL[SPECTRUMSIZE];
+		float spectrumR[SPECTRUMSIZE];
+		spectrum_kernel_c spectrum_kernel; //Smooths the spectrums and calculates the sums
+
+		//The bars after smoothing and their x coordinates from -1 to 1
+		int bar_amount;
+		float *bar_heights;
+		float *bar_positions; //bar_amount + 1 values
+
+		//Bars with constant width
+		rebin_matrix_c bar_matrix; //Combines the spectrum into the bars
+		float *bar_sumL, *bar_sumR;
+
+		//Bars with variable width
+		float bar_size[SPECTRUMSIZE - 1];
+
+		//Sizes for the squares and the background fade
+		float bass_sum;
+		float left_sum;
+		float right_sum;
+		float sound_sum;
+
+		//Previously analyzed frames of the song, NULL if not used
+		analysis_cache_c *cache;
+
+		//The temporary memory of the analysis, reset on every frame
+		frame_arena_c arena;
+
+		const analyzer_settings settings;
+
+		//The analysis of one frame with the chosen settings
+		typedef void (analyzer_c::*frame_kernel)(sound_system_c &sound_system);
+		frame_kernel analyze_spectrum;
+		static frame_kernel choose_kernel(const analyzer_settings &settings);
+		template<class BARS, bool SMOOTH_SPECTRUM> void analyze_frame(sound_system_c &sound_system);
+		template<bool SMOOTH> friend struct constant_width_bars;
+		template<bool SMOOTH> friend struct variable_width_bars;
+
+	public:
+		analyzer_c(const analyzer_settings &settings = analyzer_settings());
+		~analyzer_c();
+		void set_cache(analysis_cache_c *cache);
+		void analyze(sound_system_c &sound_system, const unsigned int samples = 0);
+
+		const analyzer_settings &get_settings() const { return settings; }
+		int get_bar_amount() const { return bar_amount; }
+		const float *get_bar_heights() const { return bar_heights; }
+		const float *get_bar_positions() const { return bar_positions; }
+		const rebin_matrix_c &get_bar_matrix() const { return bar_matrix; }
+		const float *get_spectrum_left() const { return spectrumL; }
+		const float *get_spectrum_right() const { return spectrumR; }
+		float get_bass_sum() const { return bass_sum; }
+		float get_left_sum() const { return left_sum; }
+		float get_right_sum() const { return right_sum; }
+		float get_sound_sum() const { return sound_sum; }
+};
+
+#endif
@@ -0,0 +1,104 @@
+/** bench.cpp **/
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include "bench.hpp"
+#include "spectrum_kernel.hpp"
+#include "sound_system.hpp"
+#include "analyzer.hpp"
+#include "simd.hpp"
+
+#define BENCH_ITERATIONS 20000
+
+//The smoothing and the sums the way they were calculated before spectrum_kernel_c
+void legacy_spectrum(float *spectrumL, float *spectrumR, spectrum_sums &sums) {
+	sums.bass = 0;
+	sums.left = 0;
+	sums.right = 0;
+	sums.sound = 0;
+
+	float temp_spectrumL[SPECTRUMSIZE];
+	float temp_spectrumR[SPECTRUMSIZE];
+	memcpy(temp_spectrumL, spectrumL, sizeof(float) * SPECTRUMSIZE);
+	memcpy(temp_spectrumR, spectrumR, sizeof(float) * SPECTRUMSIZE);
+	for(int i = SPECTRUM_START; i < SPECTRUM_END; i++) {
+		spectrumL[i]
+			= 0.1 * (temp_spectrumL[i - 2] + temp_spectrumL[i + 2])
+			+ 0.2 * (temp_spectrumL[i - 1] + temp_spectrumL[i + 1])
+			+ 0.4 * temp_spectrumL[i];
+		spectrumR[i]
+			= 0.1 * (temp_spectrumR[i - 2] + temp_spectrumR[i + 2])
+			+ 0.2 * (temp_spectrumR[i - 1] + temp_spectrumR[i + 1])
+			+ 0.4 * temp_spectrumR[i];
+	}
+
+	for(int i = 0; i < SPECTRUMSIZE / 128; i++) {
+		sums.bass+= (spectrumL[i] + spectrumR[i]) * ((float)SPECTRUMSIZE / 128.0 - (float)i);
+	}
+	for(int i = 0; i < SPECTRUMSIZE - 1; i++) {
+		const float mult = sqrt(i);
+		sums.left+= spectrumL[i] * mult;
+		sums.right+= spectrumR[i] * mult;
+		sums.sound+= spectrumL[i] + spectrumR[i];
+	}
+}
+
+inline float relative_error(const float a, const float b) {
+	return std::fabs(a - b) / std::max(std::fabs(b), 1e-6f);
+}
+
+//Times the legacy code and the fused kernel on the same spectrum
+void run_benchmark() {
+	//Something that looks like a spectrum of music
+	float *rawL = simd_new_floats(SPECTRUMSIZE + SPECTRUM_PADDING * 2) + SPECTRUM_PADDING;
+	float *rawR = simd_new_floats(SPECTRUMSIZE + SPECTRUM_PADDING * 2) + SPECTRUM_PADDING;
+	srand(1);
+	for(int i = 0; i < SPECTRUMSIZE; i++) {
+		rawL[i] = (float)rand() / RAND_MAX / (i + 1.0f);
+		rawR[i] = (float)rand() / RAND_MAX / (i + 1.0f);
+	}
+	float legacyL[SPECTRUMSIZE], legacyR[SPECTRUMSIZE];
+	float kernelL[SPECTRUMSIZE], kernelR[SPECTRUMSIZE];
+	spectrum_sums legacy_sums, kernel_sums;
+	spectrum_kernel_c kernel(SPECTRUMSIZE, SPECTRUM_START, SPECTRUM_END);
+	volatile float sink = 0; //Keeps the compiler from removing the work
+
+	//The legacy version includes getting the spectrum to the arrays it works in place on
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(int i = 0; i < BENCH_ITERATIONS; i++) {
+		memcpy(legacyL, rawL, sizeof(legacyL));
+		memcpy(legacyR, rawR, sizeof(legacyR));
+		legacy_spectrum(legacyL, legacyR, legacy_sums);
+		sink = sink + legacy_sums.sound;
+	}
+	const double legacy_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	start = std::chrono::steady_clock::now();
+	for(int i = 0; i < BENCH_ITERATIONS; i++) {
+		kernel.run<true>(rawL, rawR, kernelL, kernelR, kernel_sums);
+		sink = sink + kernel_sums.sound;
+	}
+	const double kernel_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	float spectrum_error = 0;
+	for(int i = 0; i < SPECTRUMSIZE; i++) {
+		spectrum_error = std::max(spectrum_error, relative_error(kernelL[i], legacyL[i]));
+		spectrum_error = std::max(spectrum_error, relative_error(kernelR[i], legacyR[i]));
+	}
+	const float sum_error = std::max(
+		std::max(relative_error(kernel_sums.bass, legacy_sums.bass), relative_error(kernel_sums.left, legacy_sums.left)),
+		std::max(relative_error(kernel_sums.right, legacy_sums.right), relative_error(kernel_sums.sound, legacy_sums.sound)));
+
+	std::cout << "Spectrum smoothing and sums, " << BENCH_ITERATIONS << " frames, SIMD width " << SIMD_WIDTH << std::endl;
+	std::cout << "  legacy: " << legacy_time / BENCH_ITERATIONS * 1000000.0 << " us per frame" << std::endl;
+	std::cout << "  fused:  " << kernel_time / BENCH_ITERATIONS * 1000000.0 << " us per frame" << std::endl;
+	std::cout << "  speedup: " << legacy_time / kernel_time << "x" << std::endl;
+	std::cout << "  largest relative difference: " << spectrum_error << " in the spectrum, " << sum_error << " in the sums" << std::endl;
+
+	simd_free(rawL - SPECTRUM_PADDING);
+	simd_free(rawR - SPECTRUM_PADDING);
+}
@@ -0,0 +1,9 @@
+/** bench.hpp **/
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+//Compares the speed and the results of the optimized analysis kernels against the original code
+void run_benchmark();
+
+#endif
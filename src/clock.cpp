@@ -0,0 +1,14 @@
+/** clock.cpp **/
+
+#include <chrono>
+#include <thread>
+#include "clock.hpp"
+
+double get_time() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void sleep_seconds(const double seconds) {
+	if(seconds > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
@@ -0,0 +1,11 @@
+/** clock.hpp **/
+
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+//Seconds from a monotonic clock that is not affected by changes to the system time
+//Works without a window unlike glfwGetTime
+double get_time();
+void sleep_seconds(const double seconds);
+
+#endif
@@ -0,0 +1,48 @@
+/** display.cpp **/
+
+#include <fstream>
+#include <GL/glew.h>
+#include <GL/glfw.h>
+#include "display.hpp"
+#include "main.hpp"
+
+//Reads the current content of the screen framebuffer as RGBA, bottom row first
+//pixels must have room for width * height * 4 bytes
+void display_c::read_frame(unsigned char *pixels) const {
+	GLint previous_framebuffer = 0;
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING_EXT, &previous_framebuffer);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, screen_framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, previous_framebuffer);
+}
+
+//Saves the current frame as a binary PPM image
+bool display_c::save_screenshot(const char *file_name) const {
+	unsigned char *pixels = new unsigned char[width * height * 4];
+	read_frame(pixels);
+
+	std::ofstream file(file_name, std::ios::out | std::ios::binary);
+	file << "P6\n" << width << " " << height << "\n255\n";
+	//OpenGL has the bottom row first
+	for(int y = height - 1; y >= 0; y--) {
+		const unsigned char *row = pixels + y * width * 4;
+		for(int x = 0; x < width; x++) file.write((const char*)row + x * 4, 3);
+	}
+	delete [] pixels;
+	return file.good();
+}
+
+window_display_c::window_display_c(): display_c(WINDOW_WIDTH, WINDOW_HEIGHT) {
+	glfwGetWindowSize(&width, &height);
+}
+
+bool window_display_c::is_open() const {
+	return !glfwGetKey(GLFW_KEY_ESC) && glfwGetWindowParam(GLFW_OPENED);
+}
+
+//Swapping also handles the window events so this is where the size changes
+void window_display_c::swap_buffers() {
+	glfwSwapBuffers();
+	glfwGetWindowSize(&width, &height);
+}
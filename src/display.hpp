@@ -0,0 +1,43 @@
+/** display.hpp **/
+
+#ifndef DISPLAY_HPP
+#define DISPLAY_HPP
+
+#include <GL/glew.h>
+
+/*
+	The place where the finished frames end up
+	The visualizer draws into the screen framebuffer of the display and then swaps the buffers
+	window_display_c is the GLFW window and headless_display_c renders without any window
+*/
+class display_c {
+	private:
+		display_c(const display_c &obj); //Copy constructor
+		display_c &operator=(const display_c &obj); //Assign operator
+
+	protected:
+		GLuint screen_framebuffer; //0 is the default framebuffer of the window
+		int width, height; //The size of the screen framebuffer, may change when the buffers are swapped
+
+	public:
+		display_c(const int width, const int height): screen_framebuffer(0), width(width), height(height) {}
+		virtual ~display_c() {}
+		virtual bool is_open() const = 0;
+		virtual void swap_buffers() = 0;
+		GLuint get_screen_framebuffer() const { return screen_framebuffer; }
+		int get_width() const { return width; }
+		int get_height() const { return height; }
+		void read_frame(unsigned char *pixels) const;
+		bool save_screenshot(const char *file_name) const;
+};
+
+//The GLFW window that main.cpp opens
+//The window can be resized and the size is updated when the buffers are swapped
+class window_display_c: public display_c {
+	public:
+		window_display_c();
+		bool is_open() const;
+		void swap_buffers();
+};
+
+#endif
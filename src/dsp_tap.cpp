@@ -0,0 +1,91 @@
+/** dsp_tap.cpp **/
+
+#include <cstring>
+#include "dsp_tap.hpp"
+#include "sound_system.hpp"
+#include "trace.hpp"
+
+//The samples are converted to stereo in blocks of this size
+#define CONVERT_BLOCK 256
+
+//Called by FMOD in the mixer thread
+FMOD_RESULT F_CALLBACK dsp_tap_read(FMOD_DSP_STATE *dsp_state, float *inbuffer, float *outbuffer, unsigned int length, int inchannels, int outchannels) {
+	tracer.set_thread_name("FMOD mixer");
+	scoped_trace_c trace("dsp_tap");
+
+	//Pass the sound through unchanged
+	memcpy(outbuffer, inbuffer, sizeof(float) * length * outchannels);
+
+	void *tap;
+	if(FMOD_DSP_GetUserData(dsp_state->instance, &tap) == FMOD_OK && tap) {
+		((dsp_tap_c*)tap)->push(inbuffer, length, inchannels);
+	}
+	return FMOD_OK;
+}
+
+dsp_tap_c::dsp_tap_c(FMOD_SYSTEM *fmod_system, const unsigned int capacity):
+	dsp(0), ring(capacity), dropped(0) {
+
+	FMOD_DSP_DESCRIPTION description;
+	memset(&description, 0, sizeof(description));
+	strcpy(description.name, "Visualizer tap");
+	description.version = 0x00010000;
+	description.channels = 0;
+	description.read = dsp_tap_read;
+	description.userdata = this;
+
+	if(FMOD_System_CreateDSP(fmod_system, &description, &dsp) != FMOD_OK) dsp = 0;
+}
+
+dsp_tap_c::~dsp_tap_c() {
+	release();
+}
+
+//The DSP unit must be released before the FMOD system is closed
+void dsp_tap_c::release() {
+	if(dsp) {
+		FMOD_DSP_Remove(dsp);
+		FMOD_DSP_Release(dsp);
+		dsp = 0;
+	}
+}
+
+//Adds the tap to the DSP chain of the given channel
+void dsp_tap_c::attach(FMOD_CHANNEL *channel) {
+	if(dsp) FMOD_Channel_AddDSP(channel, dsp, 0);
+}
+
+//Producer side, called from the mixer thread
+//Takes the first two channels of the interleaved buffer, mono is copied to both channels
+void dsp_tap_c::push(const float *buffer, const unsigned int length, const int channels) {
+	if(channels <= 0) return;
+	stereo_sample block[CONVERT_BLOCK];
+	unsigned int lost = 0;
+	for(unsigned int start = 0; start < length; start+= CONVERT_BLOCK) {
+		const unsigned int amount = std::min(length - start, (unsigned int)CONVERT_BLOCK);
+		const float *in = buffer + start * channels;
+		if(channels == 2) memcpy(block, in, sizeof(stereo_sample) * amount);
+		else {
+			for(unsigned int i = 0; i < amount; i++) {
+				block[i].left = in[i * channels];
+				block[i].right = in[i * channels + (channels > 1 ? 1 : 0)];
+			}
+		}
+		lost+= amount - ring.write(block, amount);
+	}
+	if(lost) dropped.fetch_add(lost, std::memory_order_relaxed);
+}
+
+//Consumer side
+unsigned int dsp_tap_c::read(stereo_sample *samples, const unsigned int amount) {
+	return ring.read(samples, amount);
+}
+
+unsigned int dsp_tap_c::available() const {
+	return ring.available();
+}
+
+//The amount of samples that didn't fit in the ring buffer
+unsigned int dsp_tap_c::get_dropped() const {
+	return dropped.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,44 @@
+/** dsp_tap.hpp **/
+
+#ifndef DSP_TAP_HPP
+#define DSP_TAP_HPP
+
+#include <atomic>
+#include "ring_buffer.hpp"
+
+//FMOD types, fmod.h is included in sound_system.hpp
+typedef struct FMOD_SYSTEM FMOD_SYSTEM;
+typedef struct FMOD_CHANNEL FMOD_CHANNEL;
+typedef struct FMOD_DSP FMOD_DSP;
+
+struct stereo_sample {
+	float left, right;
+};
+
+/*
+	A custom FMOD DSP unit that passes the sound through unchanged
+	  and copies every mixed block into a ring buffer for the analysis
+	The copying happens in FMODs mixer thread which never blocks:
+	  if the analysis doesn't keep up the samples that don't fit are dropped and counted
+*/
+class dsp_tap_c {
+	private:
+		dsp_tap_c(const dsp_tap_c &obj); //Copy constructor
+		dsp_tap_c &operator=(const dsp_tap_c &obj); //Assign operator
+
+		FMOD_DSP *dsp;
+		ring_buffer_c<stereo_sample> ring;
+		std::atomic<unsigned int> dropped;
+
+	public:
+		dsp_tap_c(FMOD_SYSTEM *fmod_system, const unsigned int capacity);
+		~dsp_tap_c();
+		void attach(FMOD_CHANNEL *channel);
+		void release();
+		void push(const float *buffer, const unsigned int length, const int channels);
+		unsigned int read(stereo_sample *samples, const unsigned int amount);
+		unsigned int available() const;
+		unsigned int get_dropped() const;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/** fft.cpp **/
+
+#include <cmath>
+#include "fft.hpp"
+#include "simd.hpp"
+
+#ifndef M_PI
+	#define M_PI 3.14159265358979323846
+#endif
+
+fft_c::fft_c(const int spectrum_size):
+	size(spectrum_size * 2),
+	bit_reverse(new int[size]),
+	window(simd_new_floats(size)),
+	twiddle_re(simd_new_floats(size)),
+	twiddle_im(simd_new_floats(size)),
+	re(simd_new_floats(size)),
+	im(simd_new_floats(size)) {
+
+	int bits = 0;
+	while((1 << bits) < size) bits++;
+	for(int i = 0; i < size; i++) {
+		int r = 0;
+		for(int j = 0; j < bits; j++) if(i & (1 << j)) r|= 1 << (bits - 1 - j);
+		bit_reverse[i] = r;
+	}
+
+	float window_sum = 0;
+	for(int i = 0; i < size; i++) {
+		window[i] = 1.0 - fabs(2.0 * i / (size - 1) - 1.0);
+		window_sum+= window[i];
+	}
+	scale = 2.0 / window_sum;
+
+	for(int h = 1; h < size; h*= 2) {
+		for(int j = 0; j < h; j++) {
+			twiddle_re[h + j] = cos(-M_PI * j / h);
+			twiddle_im[h + j] = sin(-M_PI * j / h);
+		}
+	}
+}
+
+fft_c::~fft_c() {
+	delete [] bit_reverse;
+	simd_free(window);
+	simd_free(twiddle_re);
+	simd_free(twiddle_im);
+	simd_free(re);
+	simd_free(im);
+}
+
+//Calculates the spectrums of the given left and right channel samples
+//Both sample arrays must contain two times the spectrum size samples
+void fft_c::analyze(const float *left, const float *right, float *spectrumL, float *spectrumR) {
+	//Window the samples and put them in bit reversed order
+	for(int i = 0; i < size; i++) {
+		const int r = bit_reverse[i];
+		re[r] = left[i] * window[i];
+		im[r] = right[i] * window[i];
+	}
+
+	//Radix-2 butterflies
+	//The first stages are too short for the vector registers
+	int h = 1;
+	for(; h < SIMD_WIDTH && h < size; h*= 2) {
+		for(int k = 0; k < size; k+= 2 * h) {
+			for(int j = 0; j < h; j++) {
+				const int a = k + j;
+				const int b = a + h;
+				const float tr = twiddle_re[h + j] * re[b] - twiddle_im[h + j] * im[b];
+				const float ti = twiddle_re[h + j] * im[b] + twiddle_im[h + j] * re[b];
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a]+= tr;
+				im[a]+= ti;
+			}
+		}
+	}
+	for(; h < size; h*= 2) {
+		for(int k = 0; k < size; k+= 2 * h) {
+			float *ra = re + k;
+			float *ia = im + k;
+			float *rb = ra + h;
+			float *ib = ia + h;
+			for(int j = 0; j < h; j+= SIMD_WIDTH) {
+				const simd_float wr = simd_load(twiddle_re + h + j);
+				const simd_float wi = simd_load(twiddle_im + h + j);
+				const simd_float xr = simd_load(rb + j);
+				const simd_float xi = simd_load(ib + j);
+				const simd_float tr = simd_sub(simd_mul(wr, xr), simd_mul(wi, xi));
+				const simd_float ti = simd_add(simd_mul(wr, xi), simd_mul(wi, xr));
+				const simd_float ar = simd_load(ra + j);
+				const simd_float ai = simd_load(ia + j);
+				simd_store(rb + j, simd_sub(ar, tr));
+				simd_store(ib + j, simd_sub(ai, ti));
+				simd_store(ra + j, simd_add(ar, tr));
+				simd_store(ia + j, simd_add(ai, ti));
+			}
+		}
+	}
+
+	//Separate the two channels using the symmetry of real input
+	//  left[k] = (Z[k] + conj(Z[N - k])) / 2
+	//  right[k] = (Z[k] - conj(Z[N - k])) / 2i
+	const int half = size / 2;
+	spectrumL[0] = fabs(re[0]) * scale * 0.5f;
+	spectrumR[0] = fabs(im[0]) * scale * 0.5f;
+	int k = 1;
+	#if SIMD_WIDTH > 1
+		const simd_float half_scale = simd_set1(scale * 0.5f);
+		for(; k + SIMD_WIDTH <= half; k+= SIMD_WIDTH) {
+			const simd_float a = simd_loadu(re + k);
+			const simd_float b = simd_loadu(im + k);
+			const simd_float c = simd_reverse(simd_loadu(re + size - k - SIMD_WIDTH + 1));
+			const simd_float d = simd_reverse(simd_loadu(im + size - k - SIMD_WIDTH + 1));
+			const simd_float lr = simd_add(a, c);
+			const simd_float li = simd_sub(b, d);
+			const simd_float rr = simd_add(b, d);
+			const simd_float ri = simd_sub(a, c);
+			simd_storeu(spectrumL + k, simd_mul(simd_sqrt(simd_add(simd_mul(lr, lr), simd_mul(li, li))), half_scale));
+			simd_storeu(spectrumR + k, simd_mul(simd_sqrt(simd_add(simd_mul(rr, rr), simd_mul(ri, ri))), half_scale));
+		}
+	#endif
+	for(; k < half; k++) {
+		const float a = re[k], b = im[k], c = re[size - k], d = im[size - k];
+		spectrumL[k] = sqrt((a + c) * (a + c) + (b - d) * (b - d)) * scale * 0.5f;
+		spectrumR[k] = sqrt((b + d) * (b + d) + (a - c) * (a - c)) * scale * 0.5f;
+	}
+}
@@ -0,0 +1,32 @@
+/** fft.hpp **/
+
+#ifndef FFT_HPP
+#define FFT_HPP
+
+/*
+	Real-input FFT that analyzes the left and right channels together
+	Both channels are packed into one complex FFT (left as the real part and right as the imaginary part)
+	  and they are separated afterwards, so two spectra cost a single transform
+	The butterflies are vectorized using the wrappers in simd.hpp
+	The output has the same layout as FMOD_Channel_GetSpectrum:
+	  spectrum_size values from 0 Hz to the nyquist frequency in linear scale
+*/
+class fft_c {
+	private:
+		fft_c(const fft_c &obj); //Copy constructor
+		fft_c &operator=(const fft_c &obj); //Assign operator
+
+		const int size; //The amount of samples in one analysis window (two times the spectrum size)
+		int *bit_reverse;
+		float *window; //Triangle window like FMOD_DSP_FFT_WINDOW_TRIANGLE
+		float *twiddle_re, *twiddle_im; //Twiddle factors of the stage with half size h are at [h, 2h)
+		float *re, *im; //Work buffers
+		float scale; //Normalizes the output so that a full volume sine wave peaks close to 1
+
+	public:
+		fft_c(const int spectrum_size);
+		~fft_c();
+		void analyze(const float *left, const float *right, float *spectrumL, float *spectrumR);
+};
+
+#endif
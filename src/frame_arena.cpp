@@ -0,0 +1,25 @@
+/** frame_arena.cpp **/
+
+#include <iostream>
+#include <cstdlib>
+#include "frame_arena.hpp"
+#include "simd.hpp"
+
+frame_arena_c::frame_arena_c(const size_t capacity):
+	memory((unsigned char*)simd_malloc(capacity)), capacity(capacity), used(0) {}
+
+frame_arena_c::~frame_arena_c() {
+	simd_free(memory);
+}
+
+//The arena is sized for the needs of a frame so running out of it is a bug
+void *frame_arena_c::allocate(const size_t size) {
+	const size_t aligned_size = (size + SIMD_ALIGNMENT - 1) / SIMD_ALIGNMENT * SIMD_ALIGNMENT;
+	if(used + aligned_size > capacity) {
+		std::cerr << "ERROR: Frame arena is full! (" << used << " + " << aligned_size << " / " << capacity << " bytes)" << std::endl;
+		abort();
+	}
+	void *p = memory + used;
+	used+= aligned_size;
+	return p;
+}
@@ -0,0 +1,31 @@
+/** frame_arena.hpp **/
+
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <cstddef>
+
+/*
+	A bump allocator for the temporary memory of a single frame
+	All the memory is allocated once in the constructor and reset frees everything at once,
+	  so the frame loop doesn't touch the heap at all
+	The allocations are aligned for SIMD
+*/
+class frame_arena_c {
+	private:
+		frame_arena_c(const frame_arena_c &obj); //Copy constructor
+		frame_arena_c &operator=(const frame_arena_c &obj); //Assign operator
+
+		unsigned char *memory;
+		const size_t capacity;
+		size_t used;
+
+	public:
+		frame_arena_c(const size_t capacity);
+		~frame_arena_c();
+		void *allocate(const size_t size);
+		float *allocate_floats(const size_t amount) { return (float*)allocate(sizeof(float) * amount); }
+		void reset() { used = 0; }
+};
+
+#endif
@@ -0,0 +1,89 @@
+/** frame_pacer.cpp **/
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include "frame_pacer.hpp"
+#include "clock.hpp"
+
+//The limits of the spin margin in seconds
+#define MIN_SPIN_MARGIN 0.0002
+#define MAX_SPIN_MARGIN 0.004
+
+frame_pacer_c::frame_pacer_c(const double fps):
+	period(1.0 / std::min(std::max(fps, MIN_TARGET_FPS), MAX_TARGET_FPS)),
+	deadline(0), frame_start(0), spin_margin(0.001), cost_index(0),
+	frames(0), missed_deadlines(0), dropped_deadlines(0) {
+
+	for(int i = 0; i < PACER_HISTORY; i++) costs[i] = 0;
+	for(int i = 0; i < PACER_BUCKETS; i++) error_histogram[i] = 0;
+}
+
+//The first frame starts now
+void frame_pacer_c::start() {
+	frame_start = get_time();
+	deadline = frame_start + period;
+}
+
+//Called when the frame is finished, for example after the swap
+void frame_pacer_c::end_frame() {
+	const double now = get_time();
+	costs[cost_index] = now - frame_start;
+	cost_index = (cost_index + 1) % PACER_HISTORY;
+	frames++;
+	if(now > deadline) missed_deadlines++;
+}
+
+//The time the next frame is expected to take
+//At most a period since a frame never starts before the deadline of the previous one
+double frame_pacer_c::predict_cost() const {
+	return std::min(*std::max_element(costs, costs + PACER_HISTORY), period);
+}
+
+//Waits until the next frame should start
+void frame_pacer_c::wait() {
+	deadline+= period;
+	double now = get_time();
+
+	//Don't try to catch up on the frames that are already late
+	if(now > deadline) {
+		const int late = (int)((now - deadline) / period) + 1;
+		dropped_deadlines+= late;
+		deadline+= late * period;
+	}
+
+	//Sleep most of the time and spin the rest
+	const double start = deadline - predict_cost();
+	const double sleep_end = start - spin_margin;
+	if(sleep_end > now) {
+		sleep_seconds(sleep_end - now);
+		now = get_time();
+		//The margin follows the overshoots quickly up and slowly down
+		const double overshoot = (now - sleep_end) * 1.25;
+		spin_margin = overshoot > spin_margin ? overshoot : spin_margin * 0.99 + overshoot * 0.01;
+		spin_margin = std::min(std::max(spin_margin, MIN_SPIN_MARGIN), MAX_SPIN_MARGIN);
+	}
+	while(now < start) {
+		std::this_thread::yield();
+		now = get_time();
+	}
+	frame_start = now;
+
+	//How far from the plan the frame started
+	static const double limits[PACER_BUCKETS - 1] = PACER_BUCKET_LIMITS;
+	const double error_ms = (now - start) * 1000.0;
+	error_histogram[std::upper_bound(limits, limits + PACER_BUCKETS - 1, error_ms) - limits]++;
+}
+
+void frame_pacer_c::print_statistics() const {
+	if(frames <= 0) return;
+	std::cout << "Frame pacing at " << 1.0 / period << " Hz: " << missed_deadlines << " of " << frames << " frames missed their deadline, "
+		<< dropped_deadlines << " deadlines were dropped" << std::endl;
+	static const double limits[PACER_BUCKETS - 1] = PACER_BUCKET_LIMITS;
+	std::cout << "  Frame start errors:";
+	for(int i = 0; i < PACER_BUCKETS; i++) {
+		if(i < PACER_BUCKETS - 1) std::cout << " <" << limits[i] << " ms: " << error_histogram[i];
+		else std::cout << " more: " << error_histogram[i];
+	}
+	std::cout << std::endl;
+}
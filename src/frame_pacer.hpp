@@ -0,0 +1,58 @@
+/** frame_pacer.hpp **/
+
+#ifndef FRAME_PACER_HPP
+#define FRAME_PACER_HPP
+
+//The range of the frame rates that can be chosen with --fps
+#define MIN_TARGET_FPS 30.0
+#define MAX_TARGET_FPS 240.0
+
+//The amount of previous frames that the cost of the next frame is predicted from
+#define PACER_HISTORY 32
+
+//The pacing errors are counted in buckets whose upper limits are these in milliseconds
+//The last bucket has everything above them
+#define PACER_BUCKETS 9
+#define PACER_BUCKET_LIMITS {0.05, 0.1, 0.25, 0.5, 1.0, 2.0, 4.0, 8.0}
+
+/*
+	Keeps the frames at a constant rate on the monotonic clock of clock.hpp
+	Every frame has a deadline when it should be finished and the deadlines are one period apart
+	wait sleeps until the next frame should start, which is its deadline minus the predicted cost of the frame,
+	  the longest of the last PACER_HISTORY frames
+	The sleep ends a bit early and the rest is spent spinning, because sleeping can overshoot
+	  the margin for that is learned from how much the sleeps have overshot
+	When a frame is late by more than a period the missed deadlines are dropped
+	  instead of running the next frames as fast as possible to catch up
+*/
+class frame_pacer_c {
+	private:
+		frame_pacer_c(const frame_pacer_c &obj); //Copy constructor
+		frame_pacer_c &operator=(const frame_pacer_c &obj); //Assign operator
+
+		const double period;
+		double deadline; //When the current frame should be finished
+		double frame_start; //When wait returned
+		double spin_margin; //Seconds before the start that the sleep ends
+
+		//The costs of the previous frames from wait to end_frame
+		double costs[PACER_HISTORY];
+		int cost_index;
+
+		//Statistics
+		int frames, missed_deadlines, dropped_deadlines;
+		unsigned int error_histogram[PACER_BUCKETS]; //How far from the planned time the frames started
+
+	public:
+		frame_pacer_c(const double fps);
+		double get_fps() const { return 1.0 / period; }
+		int get_missed_deadlines() const { return missed_deadlines; }
+		int get_dropped_deadlines() const { return dropped_deadlines; }
+		void start();
+		void end_frame();
+		void wait();
+		double predict_cost() const;
+		void print_statistics() const;
+};
+
+#endif
@@ -0,0 +1,36 @@
+/** frame_pipeline.cpp **/
+
+#include <algorithm>
+#include "frame_pipeline.hpp"
+#include "clock.hpp"
+
+frame_pipeline_c::frame_pipeline_c(const int frames_in_flight):
+	frames_in_flight(std::min(std::max(frames_in_flight, 1), MAX_FRAMES_IN_FLIGHT)), fenced(GLEW_ARB_sync), next(0), wait_time(0) {
+
+	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) fences[i] = 0;
+}
+
+frame_pipeline_c::~frame_pipeline_c() {
+	for(int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+		if(fences[i]) glDeleteSync(fences[i]);
+	}
+}
+
+//Waits until the GPU has finished the frame that was sent frames_in_flight frames ago
+//Called before anything of the new frame is written
+void frame_pipeline_c::begin_frame() {
+	if(!fenced || !fences[next]) return;
+	const double start_time = get_time();
+	while(glClientWaitSync(fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+	wait_time+= get_time() - start_time;
+	glDeleteSync(fences[next]);
+	fences[next] = 0;
+}
+
+//Called after the frame has been sent to the display
+void frame_pipeline_c::end_frame() {
+	if(!fenced) return;
+	if(fences[next]) glDeleteSync(fences[next]);
+	fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next = (next + 1) % frames_in_flight;
+}
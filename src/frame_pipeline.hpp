@@ -0,0 +1,42 @@
+/** frame_pipeline.hpp **/
+
+#ifndef FRAME_PIPELINE_HPP
+#define FRAME_PIPELINE_HPP
+
+#include <GL/glew.h>
+#include "stream_buffer.hpp"
+
+//The default and the largest amount of frames that the GPU may still be working on when the CPU starts a new one
+//The stream buffer needs a region for every frame in flight and one for the frame that is being written
+#define FRAMES_IN_FLIGHT 2
+#define MAX_FRAMES_IN_FLIGHT (STREAM_REGIONS - 1)
+
+/*
+	Keeps track of the frames that have been sent to the GPU but not finished yet
+	A fence is placed after every frame and begin_frame waits until there is room for one more
+	With one frame in flight the CPU waits for the GPU on every frame like a strictly serial loop
+	  and with more the CPU prepares the next frame while the GPU is still rendering the previous ones,
+	  which gives more time for both but shows the frames later
+	Without ARB_sync nothing is tracked and the driver decides how far ahead the CPU gets
+*/
+class frame_pipeline_c {
+	private:
+		frame_pipeline_c(const frame_pipeline_c &obj); //Copy constructor
+		frame_pipeline_c &operator=(const frame_pipeline_c &obj); //Assign operator
+
+		const int frames_in_flight;
+		const bool fenced;
+		GLsync fences[MAX_FRAMES_IN_FLIGHT];
+		int next; //The fence of the oldest frame and the place of the next one
+		double wait_time; //Seconds spent waiting for the GPU
+
+	public:
+		frame_pipeline_c(const int frames_in_flight);
+		~frame_pipeline_c();
+		int get_frames_in_flight() const { return frames_in_flight; }
+		double get_wait_time() const { return wait_time; }
+		void begin_frame();
+		void end_frame();
+};
+
+#endif
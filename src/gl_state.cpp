@@ -0,0 +1,59 @@
+/** gl_state.cpp **/
+
+#include "gl_state.hpp"
+
+//No OpenGL object has this name so the next call is always made
+#define UNKNOWN_STATE ((GLuint)-1)
+
+gl_state_c::gl_state_c(): calls(0), elided_calls(0) {
+	invalidate();
+}
+
+void gl_state_c::invalidate() {
+	program = vertex_array = array_buffer = framebuffer = texture = UNKNOWN_STATE;
+	blending = blend_function = -1;
+}
+
+//Returns true if the call must be made and counts it
+template<class T> bool gl_state_c::changed(T &current, const T value) {
+	if(current == value) {
+		elided_calls++;
+		return false;
+	}
+	current = value;
+	calls++;
+	return true;
+}
+
+void gl_state_c::use_program(const GLuint program) {
+	if(changed(this->program, program)) glUseProgram(program);
+}
+
+void gl_state_c::bind_vertex_array(const GLuint vertex_array) {
+	if(changed(this->vertex_array, vertex_array)) glBindVertexArray(vertex_array);
+}
+
+void gl_state_c::bind_array_buffer(const GLuint buffer) {
+	if(changed(array_buffer, buffer)) glBindBuffer(GL_ARRAY_BUFFER, buffer);
+}
+
+void gl_state_c::bind_framebuffer(const GLuint framebuffer) {
+	if(changed(this->framebuffer, framebuffer)) glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer);
+}
+
+void gl_state_c::bind_texture(const GLuint texture) {
+	if(changed(this->texture, texture)) glBindTexture(GL_TEXTURE_2D, texture);
+}
+
+//Enabling or disabling the blending is one call and setting the blending function is another
+void gl_state_c::set_blend(const blend_mode mode) {
+	if(mode == BLEND_NONE) {
+		if(changed(blending, 0)) glDisable(GL_BLEND);
+		return;
+	}
+	if(changed(blending, 1)) glEnable(GL_BLEND);
+	if(changed(blend_function, (int)mode)) {
+		if(mode == BLEND_ALPHA) glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		else glBlendFunc(GL_ONE, GL_ONE);
+	}
+}
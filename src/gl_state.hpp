@@ -0,0 +1,51 @@
+/** gl_state.hpp **/
+
+#ifndef GL_STATE_HPP
+#define GL_STATE_HPP
+
+#include <GL/glew.h>
+
+//The blending modes that are used
+enum blend_mode {
+	BLEND_NONE,
+	BLEND_ALPHA, //"normal" rendering
+	BLEND_ADDITIVE
+};
+
+/*
+	A shadow copy of the OpenGL state that graphics_c changes
+	A call that would set the state to what it already is is not made at all
+	The state is forgotten with invalidate whenever something else may have changed it
+	The calls that were made and skipped are counted
+*/
+class gl_state_c {
+	private:
+		gl_state_c(const gl_state_c &obj); //Copy constructor
+		gl_state_c &operator=(const gl_state_c &obj); //Assign operator
+
+		GLuint program;
+		GLuint vertex_array;
+		GLuint array_buffer;
+		GLuint framebuffer; //Bound to GL_FRAMEBUFFER but only the draw binding is trusted
+		GLuint texture; //GL_TEXTURE_2D of the texture unit 0
+		int blending; //1 when enabled, 0 when disabled and -1 when unknown
+		int blend_function; //BLEND_ALPHA, BLEND_ADDITIVE or -1 when unknown
+
+		unsigned long calls, elided_calls;
+		template<class T> bool changed(T &current, const T value);
+
+	public:
+		gl_state_c();
+		void invalidate();
+		void use_program(const GLuint program);
+		void bind_vertex_array(const GLuint vertex_array);
+		void bind_array_buffer(const GLuint buffer);
+		void bind_framebuffer(const GLuint framebuffer);
+		void bind_texture(const GLuint texture);
+		void set_blend(const blend_mode mode);
+
+		unsigned long get_calls() const { return calls; }
+		unsigned long get_elided_calls() const { return elided_calls; }
+};
+
+#endif
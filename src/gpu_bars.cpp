@@ -0,0 +1,94 @@
+/** gpu_bars.cpp **/
+
+#include <iostream>
+#include <cstring>
+#include "gpu_bars.hpp"
+
+//The buffer textures use the texture units starting from this
+//The unit 0 is used by the framebuffer of graphics_c
+#define FIRST_TEXTURE_UNIT 1
+
+gpu_bars_c::gpu_bars_c(const analyzer_c &analyzer):
+	bar_shader("src/shaders/bars.vert", "src/shaders/color.frag"),
+	bar_amount(analyzer.get_bar_amount()) {
+
+	const analyzer_settings &settings = analyzer.get_settings();
+	const rebin_matrix_c &matrix = analyzer.get_bar_matrix();
+	const int rows = settings.bar_type == 1 ? matrix.get_rows() : 0;
+	const int zero = 0;
+
+	glGenVertexArrays(1, &vao);
+	glGenBuffers(TEXTURE_AMOUNT, buffers);
+	glGenTextures(TEXTURE_AMOUNT, textures);
+
+	//The spectrum changes every frame, the rest stays the same
+	//The matrix is empty with the variable width bars
+	init_texture(SPECTRUM, GL_R32F, NULL, sizeof(float) * SPECTRUMSIZE, GL_STREAM_DRAW);
+	init_texture(POSITIONS, GL_R32F, analyzer.get_bar_positions(), sizeof(float) * (bar_amount + 1), GL_STATIC_DRAW);
+	if(rows > 0) {
+		const int *row_offsets = matrix.get_row_offsets();
+		init_texture(ROW_OFFSETS, GL_R32I, row_offsets, sizeof(int) * (rows + 1), GL_STATIC_DRAW);
+		init_texture(ROW_COLUMNS, GL_R32I, matrix.get_row_columns(), sizeof(int) * rows, GL_STATIC_DRAW);
+		init_texture(WEIGHTS, GL_R32F, matrix.get_weights(), sizeof(float) * row_offsets[rows], GL_STATIC_DRAW);
+	}
+	else {
+		init_texture(ROW_OFFSETS, GL_R32I, &zero, sizeof(int), GL_STATIC_DRAW);
+		init_texture(ROW_COLUMNS, GL_R32I, &zero, sizeof(int), GL_STATIC_DRAW);
+		init_texture(WEIGHTS, GL_R32F, &zero, sizeof(float), GL_STATIC_DRAW);
+	}
+	glActiveTexture(GL_TEXTURE0);
+
+	//The uniforms stay the same except for the color
+	bar_shader();
+	glUniform1i(bar_shader.get_uniform_location("spectrum"), FIRST_TEXTURE_UNIT + SPECTRUM);
+	glUniform1i(bar_shader.get_uniform_location("positions"), FIRST_TEXTURE_UNIT + POSITIONS);
+	glUniform1i(bar_shader.get_uniform_location("row_offsets"), FIRST_TEXTURE_UNIT + ROW_OFFSETS);
+	glUniform1i(bar_shader.get_uniform_location("row_columns"), FIRST_TEXTURE_UNIT + ROW_COLUMNS);
+	glUniform1i(bar_shader.get_uniform_location("weights"), FIRST_TEXTURE_UNIT + WEIGHTS);
+	glUniform1i(bar_shader.get_uniform_location("bar_type"), settings.bar_type);
+	glUniform1i(bar_shader.get_uniform_location("smooth_bars"), settings.smooth_bars);
+	glUniform1i(bar_shader.get_uniform_location("bar_amount"), bar_amount);
+	glUniform1i(bar_shader.get_uniform_location("spectrum_start"), SPECTRUM_START);
+	color_location = bar_shader.get_uniform_location("color");
+	glUniform4f(color_location, 1.0f, 1.0f, 1.0f, 1.0f);
+
+	if(!settings.gpu_bars) std::cerr << "WARNING: the analyzer calculates the bars even though they are drawn on the GPU" << std::endl;
+}
+
+gpu_bars_c::~gpu_bars_c() {
+	glDeleteVertexArrays(1, &vao);
+	glDeleteTextures(TEXTURE_AMOUNT, textures);
+	glDeleteBuffers(TEXTURE_AMOUNT, buffers);
+}
+
+//Creates a buffer texture and binds it to its texture unit for good
+void gpu_bars_c::init_texture(const int index, const GLenum format, const void *data, const size_t size, const GLenum usage) {
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[index]);
+	glBufferData(GL_TEXTURE_BUFFER, size, data, usage);
+	glActiveTexture(GL_TEXTURE0 + FIRST_TEXTURE_UNIT + index);
+	glBindTexture(GL_TEXTURE_BUFFER, textures[index]);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffers[index]);
+}
+
+//The colors are interpolated from the bottom to the top of the bars
+void gpu_bars_c::set_color(const float bottom_brightness, const float bottom_alpha, const float top_brightness, const float top_alpha) {
+	bar_shader();
+	glUniform4f(color_location, bottom_brightness, bottom_alpha, top_brightness, top_alpha);
+}
+
+//Uploads the latest spectrum
+//The bars only need the sum of the channels so only that is uploaded (see analysis_frame)
+void gpu_bars_c::update(const float *spectrum) {
+	glBindBuffer(GL_TEXTURE_BUFFER, buffers[SPECTRUM]);
+	void *mapped = glMapBufferRange(GL_TEXTURE_BUFFER, 0, sizeof(float) * SPECTRUMSIZE, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if(!mapped) return;
+	memcpy(mapped, spectrum, sizeof(float) * SPECTRUMSIZE);
+	glUnmapBuffer(GL_TEXTURE_BUFFER);
+}
+
+//All the bars are drawn with a single draw call
+render_command gpu_bars_c::command(const int layer, const char *name) const {
+	const draw_batch batch = {0, bar_amount};
+	const render_command command = {0, COMMAND_GENERATED, PASS_FEEDBACK, layer, bar_shader.get_program(), vao, 0, BLEND_ALPHA, batch, name};
+	return command;
+}
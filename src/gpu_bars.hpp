@@ -0,0 +1,50 @@
+/** gpu_bars.hpp **/
+
+#ifndef GPU_BARS_HPP
+#define GPU_BARS_HPP
+
+#include <GL/glew.h>
+#include "shader.hpp"
+#include "analyzer.hpp"
+#include "render_queue.hpp"
+
+/*
+	This class draws the bars with the heights calculated in the vertex shader (bars.vert)
+	The spectrum is uploaded to a buffer texture once per frame
+	  and the bar positions and the rebin matrix are static buffer textures
+	The bars are generated from gl_InstanceID and gl_VertexID so the CPU doesn't loop over them at all
+	The analyzer must use gpu_bars in its settings so that it doesn't calculate the bars either
+*/
+class gpu_bars_c {
+	private:
+		gpu_bars_c(const gpu_bars_c &obj); //Copy constructor
+		gpu_bars_c &operator=(const gpu_bars_c &obj); //Assign operator
+
+		//The buffer textures
+		enum {
+			SPECTRUM,
+			POSITIONS,
+			ROW_OFFSETS,
+			ROW_COLUMNS,
+			WEIGHTS,
+			TEXTURE_AMOUNT
+		};
+
+		shader bar_shader;
+		GLuint vao; //Has no attributes
+		GLuint buffers[TEXTURE_AMOUNT];
+		GLuint textures[TEXTURE_AMOUNT];
+		GLint color_location;
+		const int bar_amount;
+
+		void init_texture(const int index, const GLenum format, const void *data, const size_t size, const GLenum usage);
+
+	public:
+		gpu_bars_c(const analyzer_c &analyzer);
+		~gpu_bars_c();
+		void set_color(const float bottom_brightness, const float bottom_alpha, const float top_brightness, const float top_alpha);
+		void update(const float *spectrum);
+		render_command command(const int layer, const char *name) const;
+};
+
+#endif
@@ -0,0 +1,92 @@
+/** gpu_profiler.cpp **/
+
+#include <iostream>
+#include "gpu_profiler.hpp"
+
+gpu_profiler_c::gpu_profiler_c():
+	#ifdef GL_ARB_timer_query
+		timers(GLEW_ARB_timer_query),
+	#else
+		timers(false),
+	#endif
+	#ifdef GL_KHR_debug
+		debug_groups(GLEW_KHR_debug),
+	#else
+		debug_groups(false),
+	#endif
+	frame(0), timing(false), pass_amount(0), skipped_results(0) {
+
+	for(int i = 0; i < GPU_PROFILER_FRAMES; i++) used[i] = 0;
+	if(timers) glGenQueries(GPU_PROFILER_FRAMES * GPU_PROFILER_PASSES, &queries[0][0]);
+	else std::cerr << "WARNING: GL_ARB_timer_query not supported, the GPU passes are not timed" << std::endl;
+}
+
+gpu_profiler_c::~gpu_profiler_c() {
+	if(timers) glDeleteQueries(GPU_PROFILER_FRAMES * GPU_PROFILER_PASSES, &queries[0][0]);
+}
+
+//Reads the results of a frame that are ready
+void gpu_profiler_c::collect(const int frame) {
+	uint64_t frame_time = 0;
+	bool complete = true;
+	for(int i = 0; i < used[frame]; i++) {
+		GLint available = 0;
+		glGetQueryObjectiv(queries[frame][i], GL_QUERY_RESULT_AVAILABLE, &available);
+		if(!available) {
+			skipped_results++;
+			complete = false;
+			continue;
+		}
+		GLuint64 time = 0;
+		glGetQueryObjectui64v(queries[frame][i], GL_QUERY_RESULT, &time);
+		frame_time+= time;
+
+		int pass = 0;
+		while(pass < pass_amount && pass_names[pass] != query_passes[frame][i]) pass++;
+		if(pass == pass_amount) {
+			if(pass_amount == GPU_PROFILER_PASSES) continue;
+			pass_names[pass_amount++] = query_passes[frame][i];
+		}
+		pass_histograms[pass].record(time);
+	}
+	if(used[frame] > 0 && complete) frame_histogram.record(frame_time);
+	used[frame] = 0;
+}
+
+//Starts using the queries of the oldest frame
+void gpu_profiler_c::begin_frame() {
+	if(!timers) return;
+	frame = (frame + 1) % GPU_PROFILER_FRAMES;
+	collect(frame);
+}
+
+//The name must be a string that lives as long as the profiler, usually a literal
+void gpu_profiler_c::begin_pass(const char *name) {
+	#ifdef GL_KHR_debug
+		if(debug_groups) glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+	#endif
+	if(timers && used[frame] < GPU_PROFILER_PASSES) {
+		query_passes[frame][used[frame]] = name;
+		glBeginQuery(GL_TIME_ELAPSED, queries[frame][used[frame]]);
+		timing = true;
+	}
+}
+
+void gpu_profiler_c::end_pass() {
+	if(timing) {
+		glEndQuery(GL_TIME_ELAPSED);
+		used[frame]++;
+		timing = false;
+	}
+	#ifdef GL_KHR_debug
+		if(debug_groups) glPopDebugGroup();
+	#endif
+}
+
+void gpu_profiler_c::print() const {
+	if(!timers || frame_histogram.get_count() == 0) return;
+	print_histogram_header("GPU pass (ms)");
+	for(int i = 0; i < pass_amount; i++) print_histogram_row(pass_names[i], pass_histograms[i]);
+	print_histogram_row("frame", frame_histogram);
+	if(skipped_results > 0) std::cout << "  " << skipped_results << " GPU timings were not ready in time and were skipped" << std::endl;
+}
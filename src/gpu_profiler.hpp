@@ -0,0 +1,57 @@
+/** gpu_profiler.hpp **/
+
+#ifndef GPU_PROFILER_HPP
+#define GPU_PROFILER_HPP
+
+#include <GL/glew.h>
+#include "profiler.hpp"
+
+//The queries of a frame are read this many frames later, by then the GPU is usually done with them
+#define GPU_PROFILER_FRAMES 4
+
+//The most passes that are timed in one frame
+#define GPU_PROFILER_PASSES 8
+
+/*
+	Measures how long the GPU takes for every pass of graphics_c with GL_TIME_ELAPSED queries
+	The queries come from a pool with a set of queries for each of the last GPU_PROFILER_FRAMES frames
+	  and a set is read only when it comes around again, so reading the results never waits for the GPU
+	  the results that are still not ready then are skipped
+	Every pass is also a debug group with its name so that tools like RenderDoc show it
+	Without ARB_timer_query or KHR_debug those parts do nothing
+*/
+class gpu_profiler_c {
+	private:
+		gpu_profiler_c(const gpu_profiler_c &obj); //Copy constructor
+		gpu_profiler_c &operator=(const gpu_profiler_c &obj); //Assign operator
+
+		const bool timers, debug_groups;
+
+		//The query pool, the name of the pass of every query and the amount of queries used in each frame
+		GLuint queries[GPU_PROFILER_FRAMES][GPU_PROFILER_PASSES];
+		const char *query_passes[GPU_PROFILER_FRAMES][GPU_PROFILER_PASSES];
+		int used[GPU_PROFILER_FRAMES];
+		int frame;
+		bool timing; //A query is running
+
+		//The results by the name of the pass, the names are compared as pointers
+		const char *pass_names[GPU_PROFILER_PASSES];
+		histogram_c pass_histograms[GPU_PROFILER_PASSES];
+		int pass_amount;
+		histogram_c frame_histogram; //All the passes of a frame
+		unsigned int skipped_results;
+
+		void collect(const int frame);
+
+	public:
+		gpu_profiler_c();
+		~gpu_profiler_c();
+		bool is_timing() const { return timers; }
+		const histogram_c &get_frame_histogram() const { return frame_histogram; }
+		void begin_frame();
+		void begin_pass(const char *name);
+		void end_pass();
+		void print() const;
+};
+
+#endif
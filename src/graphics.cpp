@@ -1,9 +1,10 @@
 /** graphics.cpp **/
 
+#include <iostream>
 #include <GL/glew.h>
 #include <string>
 #include "graphics.hpp"
-#include "main.hpp"
+#include "profiler.hpp"
 
 /*
 	The used texture shader can be specified here
@@ -13,105 +14,339 @@
 		"rgb" - separates red green and blue channels by moving them horizontally
 	Custom shaders can be created by for example placing example.frag in the shaders-directory
 	  this shader could then be used by setting this define to "example"
+	The shader defines the function vec4 effect(vec2 tex_coord) that present.frag calls
 */
 #define SHADER_NAME "normal"
 
-graphics_c::graphics_c():
-	texture_shader("src/shaders/normal.vert", (std::string("src/shaders/") + SHADER_NAME + ".frag").c_str()),
-	color_shader("src/shaders/color.vert", "src/shaders/color.frag") {
+#define MOTION_BLUR_AMOUNT 0.25f //Amount of "motion blur" in range from 0 to 1
 
-	//Basic texture coordinates
+graphics_c::graphics_c(const int width, const int height, const GLuint screen_framebuffer):
+	texture_shader("src/shaders/normal.vert", "src/shaders/present.frag", (std::string("src/shaders/") + SHADER_NAME + ".frag").c_str()),
+	rect_shader("src/shaders/rect.vert", "src/shaders/color.frag"),
+	square_shader("src/shaders/square.vert", "src/shaders/square.frag"),
+	rect_stream(GL_COPY_WRITE_BUFFER, sizeof(rect_instance) * MAX_FRAME_RECTS), //Writing doesn't disturb the GL_ARRAY_BUFFER of the state cache
+	present_renderbuffer(0),
+	current(0), width(0), height(0),
+	screen_framebuffer(screen_framebuffer) {
+
+	//The uniform is set to the bound program and the last shader that was built is bound
+	texture_shader();
+	glUniform1f(texture_shader.get_uniform_location("decay"), MOTION_BLUR_AMOUNT);
+
+	//Basic vertices and texture coordinates
+	const float full_screen_vertices[VERTEX_ARRAY_SIZE * 2] = {
+		-1, -1,
+		 1, -1,
+		-1,  1,
+		 1,  1};
 	const float full_screen_tex_coords[VERTEX_ARRAY_SIZE * 2] = {
 		0, 0,
 		1, 0,
 		0, 1,
 		1, 1};
 
-	//Init vertex array object
+	if(!GLEW_ARB_instanced_arrays) std::cerr << "WARNING: GL_ARB_instanced_arrays not supported!" << std::endl;
+
+	//Init vertex array object for the framebuffer
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
 	//Init some OpenGL buffers
 	glGenBuffers(1, &vertex_buffer);
-	glGenBuffers(1, &color_buffer);
 	glGenBuffers(1, &tex_coord_buffer);
 
 	//Bind and init buffer for vertex data
+	//The framebuffer is always drawn to the whole screen so the vertices remain same all the time
 	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
 	glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0); //The first argument 0 is defined as "layout(location = 0)" in shader code
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), NULL, GL_STREAM_DRAW);
-
-	//Bind and init buffer for color data
-    glBindBuffer(GL_ARRAY_BUFFER, color_buffer);
-	glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0); //The first argument 1 is defined as "layout(location = 1)" in shader code
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), NULL, GL_STREAM_DRAW);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0); //The first argument 0 is defined as "layout(location = 0)" in shader code
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), full_screen_vertices, GL_STATIC_DRAW);
 
 	//Bind and init buffer for texture coordinate data
 	//Texture coordinates remain same all the time so we can already set the data
-    glBindBuffer(GL_ARRAY_BUFFER, tex_coord_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, tex_coord_buffer);
 	glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0); //The first argument 2 is defined as "layout(location = 2)" in shader code
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), full_screen_tex_coords, GL_STATIC_DRAW);
-
-	//Init texture for the framebuffer
-    glGenTextures(1, &framebuffer_tex);
-	glBindTexture(GL_TEXTURE_2D, framebuffer_tex);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, WINDOW_WIDTH, WINDOW_HEIGHT, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
-
-	//Init framebuffer object
-	//By default everything is now drawn into this buffer
-	glGenFramebuffersEXT(1, &framebuffer);
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer);
-	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, framebuffer_tex, 0);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0); //The first argument 2 is defined as "layout(location = 2)" in shader code
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), full_screen_tex_coords, GL_STATIC_DRAW);
+
+	//Init vertex array object for the rectangles
+	glGenVertexArrays(1, &rect_vao);
+	glBindVertexArray(rect_vao);
+	glGenBuffers(1, &corner_buffer);
+
+	//The corners of a rectangle are shared by all the instances
+	glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(float[VERTEX_ARRAY_SIZE * 2]), full_screen_tex_coords, GL_STATIC_DRAW);
+
+	//The rectangle and color of each instance
+	//The pointers are set to the batch in draw_rects
+	glEnableVertexAttribArray(1);
+	glVertexAttribDivisorARB(1, 1);
+	glEnableVertexAttribArray(2);
+	glVertexAttribDivisorARB(2, 1);
+
+	//The squares use the same corners and have their own instance data
+	//The pointers are set to the batch in draw_squares
+	glGenVertexArrays(1, &square_vao);
+	glBindVertexArray(square_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, corner_buffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, 0);
+	for(int i = 1; i <= 3; i++) {
+		glEnableVertexAttribArray(i);
+		glVertexAttribDivisorARB(i, 1);
+	}
+
+	//Everything is white until the palette is set
+	for(int i = 0; i < PALETTE_SIZE * 4; i++) palette[i] = 1.0f;
+	palette_location = rect_shader.get_uniform_location("palette");
+	rect_shader();
+	glUniform4fv(palette_location, PALETTE_SIZE, palette);
+	square_palette_location = square_shader.get_uniform_location("palette");
+	square_shader();
+	glUniform4fv(square_palette_location, PALETTE_SIZE, palette);
+
+	//Init the feedback textures and their framebuffer objects
+	const GLenum decay_buffers[2] = {GL_NONE, GL_COLOR_ATTACHMENT0_EXT};
+	glGenTextures(2, feedback_tex);
+	glGenFramebuffersEXT(2, feedback_framebuffer);
+	glGenFramebuffersEXT(2, decay_framebuffer);
+	for(int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, feedback_tex[i]);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, feedback_framebuffer[i]);
+		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, feedback_tex[i], 0);
+
+		//The faded copy is the second output of the present shader
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, decay_framebuffer[i]);
+		glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, feedback_tex[i], 0);
+		glDrawBuffers(2, decay_buffers);
+	}
+	resize(width, height);
+
+	//An offscreen screen is drawn to together with the faded copy
+	//The default framebuffer of the window can't be combined with a texture
+	//  so the shown frame is drawn to a renderbuffer of the screen size and copied to the window
+	present_framebuffer[0] = present_framebuffer[1] = 0;
+	GLint shown_renderbuffer = 0;
+	if(screen_framebuffer) {
+		GLint type = GL_NONE;
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, screen_framebuffer);
+		glGetFramebufferAttachmentParameterivEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE_EXT, &type);
+		if(type == GL_RENDERBUFFER_EXT) glGetFramebufferAttachmentParameterivEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME_EXT, &shown_renderbuffer);
+	}
+	else if(GLEW_EXT_framebuffer_blit) {
+		glGenRenderbuffersEXT(1, &present_renderbuffer);
+		glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, present_renderbuffer);
+		glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, this->width, this->height);
+		shown_renderbuffer = present_renderbuffer;
+	}
+	if(shown_renderbuffer) {
+		const GLenum present_buffers[2] = {GL_COLOR_ATTACHMENT0_EXT, GL_COLOR_ATTACHMENT1_EXT};
+		bool complete = true;
+		glGenFramebuffersEXT(2, present_framebuffer);
+		for(int i = 0; i < 2; i++) {
+			glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, present_framebuffer[i]);
+			glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, shown_renderbuffer);
+			glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT1_EXT, GL_TEXTURE_2D, feedback_tex[1 - i], 0);
+			glDrawBuffers(2, present_buffers);
+			glReadBuffer(GL_COLOR_ATTACHMENT0_EXT); //For the blit to the window
+			if(glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT) complete = false;
+		}
+		if(!complete) {
+			glDeleteFramebuffersEXT(2, present_framebuffer);
+			present_framebuffer[0] = present_framebuffer[1] = 0;
+		}
+	}
+	if(present_renderbuffer && !present_framebuffer[0]) {
+		glDeleteRenderbuffersEXT(1, &present_renderbuffer);
+		present_renderbuffer = 0;
+	}
+
+	//By default everything is now drawn into the feedback texture
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, feedback_framebuffer[current]);
 }
 
 graphics_c::~graphics_c() {
 	glDeleteVertexArrays(1, &vao);
 	glDeleteBuffers(1, &vertex_buffer);
-	glDeleteBuffers(1, &color_buffer);
 	glDeleteBuffers(1, &tex_coord_buffer);
+	glDeleteVertexArrays(1, &rect_vao);
+	glDeleteVertexArrays(1, &square_vao);
+	glDeleteBuffers(1, &corner_buffer);
 
-	glDeleteTextures(1, &framebuffer_tex);
-	glDeleteFramebuffersEXT(1, &framebuffer);
+	glDeleteTextures(2, feedback_tex);
+	glDeleteFramebuffersEXT(2, feedback_framebuffer);
+	glDeleteFramebuffersEXT(2, decay_framebuffer);
+	if(present_framebuffer[0]) glDeleteFramebuffersEXT(2, present_framebuffer);
+	if(present_renderbuffer) glDeleteRenderbuffersEXT(1, &present_renderbuffer);
 }
 
-//Draw using the given vertices and their colors
-//Expects 4 vertices
-void graphics_c::draw_arrays(const float *vertices, const float* colors) const {
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float[VERTEX_ARRAY_SIZE * 2]), vertices);
-	glBindBuffer(GL_ARRAY_BUFFER, color_buffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float[VERTEX_ARRAY_SIZE * 2]), colors);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE);
+//Reallocates the feedback textures when the size of the screen changes
+//The textures are cleared so the motion blur starts from scratch
+void graphics_c::resize(const int width, const int height) {
+	if(width == this->width && height == this->height) return;
+	if(width <= 0 || height <= 0) return; //Minimized window
+	this->width = width;
+	this->height = height;
+	for(int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, feedback_tex[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, NULL);
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, feedback_framebuffer[i]);
+		glClear(GL_COLOR_BUFFER_BIT);
+	}
+	if(present_renderbuffer) {
+		glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, present_renderbuffer);
+		glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, width, height);
+	}
+	glViewport(0, 0, width, height);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, feedback_framebuffer[current]);
 }
 
-//By default everything is first drawn into the framebuffer object here
-//This function draws the content of the framebuffer object to the main framebuffer that is actually visible on screen
-//This way some "motion blur" can be produced
-//This function should be called before swapping the screen to actually see the updates
-void graphics_c::draw_framebuffer() const {
-	//Enable main framebuffer and use texturing shader
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
-	texture_shader();
+//Sets the colors of the rectangles that use the given palette index
+//The colors are interpolated from the bottom to the top of the rectangle
+void graphics_c::set_palette_color(const int index, const float bottom_brightness, const float bottom_alpha, const float top_brightness, const float top_alpha) {
+	palette[index * 4] = bottom_brightness;
+	palette[index * 4 + 1] = bottom_alpha;
+	palette[index * 4 + 2] = top_brightness;
+	palette[index * 4 + 3] = top_alpha;
+	rect_shader();
+	glUniform4fv(palette_location, PALETTE_SIZE, palette);
+	square_shader();
+	glUniform4fv(square_palette_location, PALETTE_SIZE, palette);
+}
 
-	//Draw the content of our framebuffer object
-	//The framebuffer texture was already bound in the initialization
-	const float full_screen_vertices[VERTEX_ARRAY_SIZE * 2] = {
-		-1, -1,
-		 1, -1,
-		-1,  1,
-		 1,  1};
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float[VERTEX_ARRAY_SIZE * 2]), full_screen_vertices);
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE);
+//Starts writing the rectangles of a new frame
+//Anything may have changed the OpenGL state between the frames so the state cache starts from scratch
+void graphics_c::begin_frame() {
+	state.invalidate();
+	gpu_profiler.begin_frame();
+	if(!rect_stream.begin_frame()) std::cerr << "Couldn't map the rectangle buffer!" << std::endl;
+}
+
+//Returns memory for amount rectangles that are drawn later with rect_command(layer, blend, batch)
+//Returns NULL and sets the batch empty if the frame has too many rectangles
+rect_instance *graphics_c::allocate_rects(const int amount, draw_batch &batch) {
+	rect_instance *rects = (rect_instance*)rect_stream.allocate(sizeof(rect_instance) * amount, batch.offset);
+	batch.amount = rects ? amount : 0;
+	return rects;
+}
+
+//Returns memory for amount squares that are drawn later with square_command(layer, blend, batch)
+//Returns NULL and sets the batch empty if the frame has too many rectangles and squares
+square_instance *graphics_c::allocate_squares(const int amount, draw_batch &batch) {
+	square_instance *squares = (square_instance*)rect_stream.allocate(sizeof(square_instance) * amount, batch.offset);
+	batch.amount = squares ? amount : 0;
+	return squares;
+}
+
+//Must be called after all the rectangles of the frame are written and before they are drawn
+void graphics_c::end_writing() {
+	rect_stream.end_writing();
+}
+
+//A batch of rectangles drawn with a single draw call
+//The rectangles are drawn in the order they were written
+render_command graphics_c::rect_command(const int layer, const blend_mode blend, const draw_batch &batch, const char *name) const {
+	const render_command command = {0, COMMAND_RECTS, PASS_FEEDBACK, layer, rect_shader.get_program(), rect_vao, rect_stream.get_buffer(), blend, batch, name};
+	return command;
+}
+
+//A batch of squares drawn with a single draw call
+//Every square is drawn only once, the motion blur is calculated in the fragment shader
+render_command graphics_c::square_command(const int layer, const blend_mode blend, const draw_batch &batch, const char *name) const {
+	const render_command command = {0, COMMAND_SQUARES, PASS_FEEDBACK, layer, square_shader.get_program(), square_vao, rect_stream.get_buffer(), blend, batch, name};
+	return command;
+}
+
+//Everything is first drawn into the current feedback texture
+//This command shows the texture on the screen framebuffer that is actually visible on screen
+//  and the next frame is drawn on top of a faded copy of it, this way some "motion blur" can be produced
+//This command should be submitted before swapping the screen to actually see the updates
+render_command graphics_c::present_command() const {
+	const draw_batch batch = {0, 1};
+	const render_command command = {0, COMMAND_PRESENT, PASS_PRESENT, 0, texture_shader.get_program(), vao, 0, BLEND_NONE, batch, "present"};
+	return command;
+}
+
+//Draws the recorded commands in the order of their keys and empties the queue
+void graphics_c::submit(render_queue_c &queue) {
+	//The profiler stages of the command types
+	static const profile_stage stages[] = {STAGE_DRAW_RECTS, STAGE_DRAW_SQUARES, STAGE_DRAW_GPU_BARS, STAGE_PRESENT};
+
+	queue.sort();
+	for(int i = 0; i < queue.get_amount(); i++) {
+		const render_command &command = queue[i];
+		if(command.batch.amount <= 0) continue;
+		scoped_timer_c timer(stages[command.type]);
+		gpu_profiler.begin_pass(command.name);
+
+		state.use_program(command.program);
+		state.bind_vertex_array(command.vertex_array);
+		state.set_blend(command.blend);
+		if(command.type == COMMAND_PRESENT) {
+			present();
+			gpu_profiler.end_pass();
+			continue;
+		}
+		state.bind_framebuffer(feedback_framebuffer[current]);
+
+		//The instance attributes point to the batch
+		const size_t offset = command.batch.offset;
+		if(command.type == COMMAND_RECTS) {
+			state.bind_array_buffer(command.buffer);
+			glVertexAttribPointer(1, 4, GL_SHORT, GL_TRUE, sizeof(rect_instance), (const void*)offset);
+			glVertexAttribIPointer(2, 1, GL_UNSIGNED_SHORT, sizeof(rect_instance), (const void*)(offset + 4 * sizeof(GLshort)));
+		}
+		else if(command.type == COMMAND_SQUARES) {
+			state.bind_array_buffer(command.buffer);
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(square_instance), (const void*)offset);
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(square_instance), (const void*)(offset + 3 * sizeof(GLfloat)));
+			glVertexAttribIPointer(3, 1, GL_UNSIGNED_SHORT, sizeof(square_instance), (const void*)(offset + 5 * sizeof(GLfloat)));
+		}
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE, command.batch.amount);
+		gpu_profiler.end_pass();
+	}
+	queue.clear();
+}
+
+//The program, the vertex array and the blending are already set by submit
+void graphics_c::present() {
+	const int next = 1 - current;
+	state.bind_texture(feedback_tex[current]);
+
+	if(present_framebuffer[current]) {
+		//Both the shown frame and the faded copy in one pass
+		state.bind_framebuffer(present_framebuffer[current]);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE);
+
+		//The window gets a copy of the shown frame
+		if(present_renderbuffer) {
+			glBindFramebufferEXT(GL_DRAW_FRAMEBUFFER_EXT, screen_framebuffer);
+			glBlitFramebufferEXT(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+			state.bind_framebuffer(screen_framebuffer);
+		}
+	}
+	else {
+		state.bind_framebuffer(screen_framebuffer);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE);
+		state.bind_framebuffer(decay_framebuffer[next]);
+		glDrawArrays(GL_TRIANGLE_STRIP, 0, VERTEX_ARRAY_SIZE);
+	}
+
+	//Again draw everything else to the feedback texture
+	current = next;
+	state.bind_framebuffer(feedback_framebuffer[current]);
+}
 
-	//Again draw to the framebuffer object without texturing
-	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, framebuffer);
-	color_shader();
+//Must be called after the commands of the frame are submitted
+//The part of the stream buffer used by this frame is not written again until the GPU is done with it
+void graphics_c::end_frame() {
+	rect_stream.end_frame();
 }
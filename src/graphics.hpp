@@ -3,14 +3,71 @@
 #ifndef GRAPHICS_HPP
 #define GRAPHICS_HPP
 
+#include <algorithm>
 #include "shader.hpp"
+#include "stream_buffer.hpp"
+#include "gl_state.hpp"
+#include "render_queue.hpp"
+#include "gpu_profiler.hpp"
 
 //We will only draw rectangles and they consist of 4 vertices
 #define VERTEX_ARRAY_SIZE 4
 
+//The rectangle coordinates can be from -RECT_RANGE to RECT_RANGE so that things can go over the edges of the screen
+//Must be the same as in rect.vert
+#define RECT_RANGE 4.0f
+
+//The amount of colors in the palette
+#define PALETTE_SIZE 8
+
+//The most rectangles and squares that can be drawn in one frame
+#define MAX_FRAME_RECTS 16384
+
+/*
+	One rectangle of a batch, the corners are normalized shorts
+	The colors are indices to the palette of graphics_c
+*/
+struct rect_instance {
+	GLshort x1, y1, x2, y2;
+	GLushort color;
+	GLushort padding;
+};
+
+inline GLshort to_rect_coordinate(const float value) {
+	return std::min(std::max(value / RECT_RANGE, -1.0f), 1.0f) * 32767.0f;
+}
+
+//The corners are from -1 to 1 like OpenGLs coordinates, (x1, y1) is the bottom left corner
+inline rect_instance make_rect(const float x1, const float y1, const float x2, const float y2, const int color) {
+	const rect_instance rect = {to_rect_coordinate(x1), to_rect_coordinate(y1), to_rect_coordinate(x2), to_rect_coordinate(y2), (GLushort)color, 0};
+	return rect;
+}
+
+/*
+	A square that is drawn with motion blur in closed form (see square.frag)
+	The size is half of the height and goes from size to end_size during the blur
+	The color is an index to the palette of graphics_c
+*/
+struct square_instance {
+	GLfloat x, y, width_ratio;
+	GLfloat size, end_size;
+	GLushort color;
+	GLushort padding;
+};
+
 /*
 	This class handles all the actual drawing using vertex array objects for drawing
-	Also uses framebuffer objects for "motion blur"
+	The rectangles are drawn in batches with instancing so a whole layer of them takes a single draw call
+	All the rectangles of a frame are written at once to a stream buffer between begin_frame and end_writing
+	  and the batches are drawn after that so the CPU never waits for the GPU to finish with the buffer
+	The draws are recorded as commands to a render_queue_c and submitted sorted by their state
+	  every command is timed on the GPU as a pass of its own (see gpu_profiler.hpp)
+	  and all the state changes go through a state cache that skips the redundant ones
+	The squares have their own shader that draws each of them once with the motion blur
+	Everything is drawn to one of two feedback textures of the screen size for "motion blur"
+	  present shows the texture and writes a faded copy of it to the other texture that the next frame is drawn on
+	  both are done in a single pass: the window can't be drawn to together with a texture,
+	  so with a window the shown frame goes to a renderbuffer that is then copied to the window with a blit
 */
 class graphics_c {
 	private:
@@ -19,17 +76,49 @@ class graphics_c {
 
 		//Shaders
 		shader texture_shader;
-		shader color_shader;
+		shader rect_shader;
+		shader square_shader;
 
 		//Buffers
-		GLuint vao, vertex_buffer, color_buffer, tex_coord_buffer;
-		GLuint framebuffer_tex, framebuffer;
+		GLuint vao, vertex_buffer, tex_coord_buffer; //The full screen rectangle for drawing the framebuffer
+		GLuint rect_vao, corner_buffer; //The batches of rectangles
+		GLuint square_vao; //The batches of squares, uses the same corners
+		stream_buffer_c rect_stream; //The rectangles and the squares of the batches
+
+		//The feedback textures are used in turns
+		GLuint feedback_tex[2];
+		GLuint feedback_framebuffer[2]; //Everything is drawn here
+		GLuint decay_framebuffer[2]; //Only gets the faded copy when present needs two passes
+		GLuint present_framebuffer[2]; //The shown frame and the faded copy, 0 if not possible
+		GLuint present_renderbuffer; //The shown frame when the screen is the window, 0 otherwise
+		int current; //The feedback texture of the current frame
+		int width, height;
+		const GLuint screen_framebuffer; //Where present draws, 0 is the window
+
+		gl_state_c state;
+		gpu_profiler_c gpu_profiler;
+
+		float palette[PALETTE_SIZE * 4];
+		GLint palette_location, square_palette_location;
+
+		void present();
 
 	public:
-		graphics_c();
+		graphics_c(const int width, const int height, const GLuint screen_framebuffer = 0);
 		~graphics_c();
-		void draw_arrays(const float *vertices, const float* colors) const;
-		void draw_framebuffer() const;
+		void set_palette_color(const int index, const float bottom_brightness, const float bottom_alpha, const float top_brightness, const float top_alpha);
+		void begin_frame();
+		rect_instance *allocate_rects(const int amount, draw_batch &batch);
+		square_instance *allocate_squares(const int amount, draw_batch &batch);
+		void end_writing();
+		render_command rect_command(const int layer, const blend_mode blend, const draw_batch &batch, const char *name) const;
+		render_command square_command(const int layer, const blend_mode blend, const draw_batch &batch, const char *name) const;
+		render_command present_command() const;
+		void submit(render_queue_c &queue);
+		void resize(const int width, const int height);
+		void end_frame();
+		const gl_state_c &get_state() const { return state; }
+		const gpu_profiler_c &get_gpu_profiler() const { return gpu_profiler; }
 };
 
 #endif
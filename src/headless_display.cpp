@@ -0,0 +1,120 @@
+/** headless_display.cpp **/
+
+#include <iostream>
+#include <cstring>
+#include <GL/glew.h>
+#include "headless_display.hpp"
+
+#ifndef _WIN32
+	#include <EGL/egl.h>
+	#include <EGL/eglext.h>
+
+	#ifndef EGL_PLATFORM_SURFACELESS_MESA
+		#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+	#endif
+
+	//Opens the EGL display, preferring the surfaceless platform that doesn't need a display server or a GPU
+	EGLDisplay open_egl_display() {
+		const char *extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if(extensions && strstr(extensions, "EGL_MESA_platform_surfaceless") && get_platform_display) {
+			EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if(display != EGL_NO_DISPLAY) return display;
+		}
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	headless_display_c::headless_display_c(const int width, const int height):
+		display_c(width, height), egl_display(NULL), egl_context(NULL), screen_renderbuffer(0) {
+
+		EGLDisplay display = open_egl_display();
+		EGLint major, minor;
+		if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			std::cerr << "Couldn't initialize EGL!" << std::endl;
+			return;
+		}
+		egl_display = display;
+		std::cout << "Using EGL version: " << major << "." << minor << " (" << eglQueryString(display, EGL_VENDOR) << ")" << std::endl;
+
+		//The context is used without any surface
+		if(!strstr(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+			std::cerr << "EGL doesn't support contexts without a surface!" << std::endl;
+			return;
+		}
+
+		//EGL_SURFACE_TYPE defaults to windows so it is cleared
+		const EGLint config_attributes[] = {
+			EGL_SURFACE_TYPE, 0,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+			EGL_NONE};
+		EGLConfig config;
+		EGLint config_amount = 0;
+		if(!eglBindAPI(EGL_OPENGL_API) || !eglChooseConfig(display, config_attributes, &config, 1, &config_amount) || config_amount == 0) {
+			std::cerr << "Couldn't find an OpenGL config for EGL!" << std::endl;
+			return;
+		}
+
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+			EGL_CONTEXT_MINOR_VERSION_KHR, 1,
+			EGL_NONE};
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+		if(context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+			std::cerr << "Couldn't create an OpenGL 3.1 context with EGL!" << std::endl;
+			if(context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+			return;
+		}
+
+		//GLEW also tries to initialize GLX which fails without an X display but OpenGL itself is fine
+		const GLenum glew_result = glewInit();
+		#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+			if(glew_result != GLEW_OK && glew_result != GLEW_ERROR_NO_GLX_DISPLAY) {
+		#else
+			if(glew_result != GLEW_OK) {
+		#endif
+			std::cerr << "Couldn't initialize GLEW!" << std::endl;
+			eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(display, context);
+			return;
+		}
+		egl_context = context;
+
+		//There is no default framebuffer so the screen is a framebuffer object
+		glGenRenderbuffersEXT(1, &screen_renderbuffer);
+		glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, screen_renderbuffer);
+		glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, width, height);
+		glGenFramebuffersEXT(1, &screen_framebuffer);
+		glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, screen_framebuffer);
+		glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_RENDERBUFFER_EXT, screen_renderbuffer);
+		if(glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT) != GL_FRAMEBUFFER_COMPLETE_EXT) std::cerr << "The offscreen framebuffer is not complete!" << std::endl;
+
+		//Without a surface the viewport isn't set automatically
+		glViewport(0, 0, width, height);
+	}
+
+	headless_display_c::~headless_display_c() {
+		if(egl_context) {
+			glDeleteFramebuffersEXT(1, &screen_framebuffer);
+			glDeleteRenderbuffersEXT(1, &screen_renderbuffer);
+			eglMakeCurrent(egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(egl_display, egl_context);
+		}
+		if(egl_display) eglTerminate(egl_display);
+	}
+
+	//There is nothing to show so this only sends the frame to the GPU
+	//The visualizer waits for the frame with a fence when it needs to (see frame_pipeline.hpp)
+	void headless_display_c::swap_buffers() {
+		glFlush();
+	}
+#else
+	headless_display_c::headless_display_c(const int width, const int height):
+		display_c(width, height), egl_display(NULL), egl_context(NULL), screen_renderbuffer(0) {
+		std::cerr << "Headless rendering is not supported on Windows!" << std::endl;
+	}
+
+	headless_display_c::~headless_display_c() {}
+
+	void headless_display_c::swap_buffers() {}
+#endif
@@ -0,0 +1,26 @@
+/** headless_display.hpp **/
+
+#ifndef HEADLESS_DISPLAY_HPP
+#define HEADLESS_DISPLAY_HPP
+
+#include "display.hpp"
+
+/*
+	Renders without a window or a display server using an EGL context without any surface
+	The frames go to an offscreen framebuffer object of the given size where they can be read back
+	This works on machines without a GPU with Mesa llvmpipe (EGL_PLATFORM_SURFACELESS_MESA)
+	Not available on Windows
+*/
+class headless_display_c: public display_c {
+	private:
+		void *egl_display, *egl_context;
+		GLuint screen_renderbuffer;
+
+	public:
+		headless_display_c(const int width, const int height);
+		~headless_display_c();
+		bool is_open() const { return egl_context != NULL; }
+		void swap_buffers();
+};
+
+#endif
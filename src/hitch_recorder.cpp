@@ -0,0 +1,145 @@
+/** hitch_recorder.cpp **/
+
+#include <iostream>
+#include <cstdio>
+#include <ctime>
+#include <algorithm>
+#include "hitch_recorder.hpp"
+#include "clock.hpp"
+
+hitch_recorder_c::hitch_recorder_c():
+	recording(false), directory_length(0), threshold(0), frame_amount(0), frames_after(-1), first_late_frame(0), late_frames(0),
+	snapshot_frames(0), snapshot_late_frames(0), snapshot_hitch(0), snapshot_pending(false), stopping(false),
+	hitches(0), dropped_hitches(0), files(0) {}
+
+hitch_recorder_c::~hitch_recorder_c() {
+	stop();
+}
+
+//The late frames are written to directory from now on
+void hitch_recorder_c::start(const char *directory, const double threshold, const double fps) {
+	if(writer.joinable()) return;
+	directory_length = snprintf(file_name, HITCH_PATH_SIZE, "%s/", directory);
+	if(directory_length < 0 || directory_length > HITCH_PATH_SIZE - 64) {
+		std::cerr << "The directory for the late frames is too long: " << directory << std::endl;
+		return;
+	}
+	recording = true;
+	this->threshold = threshold / fps * 1000000000.0;
+	stopping = false;
+	writer = std::thread(&hitch_recorder_c::write_snapshots, this);
+}
+
+//Writes the late frames that are still waiting for the frames after them and waits for the files
+void hitch_recorder_c::stop() {
+	if(!writer.joinable()) return;
+	if(frames_after >= 0) take_snapshot();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	changed.notify_all();
+	writer.join();
+}
+
+//Called after profiler.end_frame with the latest state of FMOD
+void hitch_recorder_c::record(const sound_status &sound, const double song_position) {
+	if(!recording) return;
+	hitch_frame &frame = frames[frame_amount % HITCH_FRAMES];
+	frame.number = frame_amount++;
+	frame.time = get_time();
+	frame.song_position = song_position;
+	for(int i = 0; i < STAGE_AMOUNT; i++) frame.stage_times[i] = profiler.get_frame_time((profile_stage)i) / 1000000.0f;
+	frame.sound = sound;
+
+	if(profiler.get_frame_time(STAGE_FRAME) > threshold) {
+		hitches++;
+		late_frames++;
+		if(frames_after < 0) {
+			frames_after = 0;
+			first_late_frame = frame.number;
+		}
+	}
+	if(frames_after >= 0 && frames_after++ == HITCH_FRAMES_AFTER) take_snapshot();
+}
+
+//Gives a copy of the ring to the writer thread unless it is still busy
+void hitch_recorder_c::take_snapshot() {
+	frames_after = -1;
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if(!lock.owns_lock() || snapshot_pending) {
+		dropped_hitches+= late_frames;
+		late_frames = 0;
+		return;
+	}
+
+	//Oldest first
+	snapshot_frames = (int)std::min(frame_amount, (uint64_t)HITCH_FRAMES);
+	for(int i = 0; i < snapshot_frames; i++) snapshot[i] = frames[(frame_amount - snapshot_frames + i) % HITCH_FRAMES];
+	snapshot_late_frames = late_frames;
+	snapshot_hitch = first_late_frame;
+	snapshot_pending = true;
+	late_frames = 0;
+	lock.unlock();
+	changed.notify_all();
+}
+
+//The writer thread
+void hitch_recorder_c::write_snapshots() {
+	tracer.set_thread_name("hitch writer");
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		if(!snapshot_pending) {
+			if(stopping) return;
+			changed.wait(lock);
+			continue;
+		}
+		lock.unlock();
+
+		//For example hitch-20240131-235959-frame1234.json
+		char date[32];
+		const std::time_t now = std::time(NULL);
+		std::strftime(date, sizeof(date), "%Y%m%d-%H%M%S", std::localtime(&now));
+		snprintf(file_name + directory_length, HITCH_PATH_SIZE - directory_length, "hitch-%s-frame%llu.json", date, (unsigned long long)snapshot_hitch);
+		if(write_snapshot()) {
+			std::cout << "Wrote " << snapshot_late_frames << " late frames and the frames around them to " << file_name << std::endl;
+			files++;
+		}
+		else std::cerr << "Couldn't write the late frames to " << file_name << std::endl;
+
+		lock.lock();
+		snapshot_pending = false;
+	}
+}
+
+bool hitch_recorder_c::write_snapshot() {
+	scoped_trace_c trace("write_hitch");
+	FILE *file = fopen(file_name, "w");
+	if(!file) return false;
+	setvbuf(file, file_buffer, _IOFBF, HITCH_FILE_BUFFER_SIZE);
+
+	fprintf(file, "{\"threshold_ms\":%.4f,\"late_frames\":%d,\"first_late_frame\":%llu,\"stages\":[",
+		threshold / 1000000.0, snapshot_late_frames, (unsigned long long)snapshot_hitch);
+	for(int i = 0; i < STAGE_AMOUNT; i++) fprintf(file, "%s\"%s\"", i ? "," : "", profiler_c::get_stage_name((profile_stage)i));
+	fprintf(file, "],\n\"frames\":[\n");
+	for(int i = 0; i < snapshot_frames; i++) {
+		const hitch_frame &frame = snapshot[i];
+		const sound_status &sound = frame.sound;
+		fprintf(file, "%s{\"frame\":%llu,\"time\":%.4f,\"song_position\":%.4f,\"stage_ms\":[", i ? ",\n" : "", (unsigned long long)frame.number, frame.time, frame.song_position);
+		for(int j = 0; j < STAGE_AMOUNT; j++) fprintf(file, "%s%.4f", j ? "," : "", frame.stage_times[j]);
+		fprintf(file, "],\"fmod_cpu\":{\"dsp\":%.4f,\"stream\":%.4f,\"update\":%.4f,\"total\":%.4f}",
+			sound.dsp_usage, sound.stream_usage, sound.update_usage, sound.total_usage);
+		fprintf(file, ",\"open_state\":%d,\"percent_buffered\":%u,\"starving\":%s,\"disk_busy\":%s,\"fmod_memory\":%d}",
+			sound.open_state, sound.percent_buffered, sound.starving ? "true" : "false", sound.disk_busy ? "true" : "false", sound.memory_used);
+	}
+	fprintf(file, "\n]}\n");
+	const bool written = !ferror(file);
+	return fclose(file) == 0 && written;
+}
+
+void hitch_recorder_c::print_statistics() const {
+	if(!recording) return;
+	std::cout << "Late frames: " << hitches << " over " << threshold / 1000000.0 << " ms, written to " << files << " files";
+	if(dropped_hitches > 0) std::cout << ", " << dropped_hitches << " not written as the previous file was still being written";
+	std::cout << std::endl;
+}
@@ -0,0 +1,86 @@
+/** hitch_recorder.hpp **/
+
+#ifndef HITCH_RECORDER_HPP
+#define HITCH_RECORDER_HPP
+
+#include <cstdio>
+#include <stdint.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "profiler.hpp"
+#include "sound_system.hpp"
+
+//The amount of the latest frames that are kept and written when a frame is late
+//Some frames after the late frame are recorded too before the frames are written
+#define HITCH_FRAMES 300
+#define HITCH_FRAMES_AFTER 30
+
+//The longest path of a file and the buffer that a file is written through
+#define HITCH_PATH_SIZE 1024
+#define HITCH_FILE_BUFFER_SIZE 65536
+
+//A frame is late when it takes this many periods of the frame rate, can be changed with --hitch-threshold
+#define HITCH_THRESHOLD 2.0
+
+/*
+	A flight recorder for the frames that are much later than they should be
+	The durations of the stages and the state of FMOD of the latest HITCH_FRAMES frames are kept in a ring
+	When a frame takes longer than the threshold the ring is copied and written to a JSON file
+	  in the given directory by a thread of its own, so the render thread never waits for the disk
+	If the thread is still writing the previous file the late frames are only counted
+	The file is written with C stdio through a buffer of its own so writing doesn't allocate with new
+	  which would fail the frames of the COUNT_ALLOCATIONS build
+	Recording a frame is only a copy of the frame to the ring when nothing is late
+*/
+class hitch_recorder_c {
+	private:
+		hitch_recorder_c(const hitch_recorder_c &obj); //Copy constructor
+		hitch_recorder_c &operator=(const hitch_recorder_c &obj); //Assign operator
+
+		struct hitch_frame {
+			uint64_t number;
+			double time; //When the frame ended on the clock of clock.hpp
+			double song_position; //Seconds in the song of the shown sound
+			float stage_times[STAGE_AMOUNT]; //Milliseconds
+			sound_status sound;
+		};
+
+		bool recording;
+		char file_name[HITCH_PATH_SIZE]; //The directory is written here by start, the writer thread adds the rest
+		int directory_length;
+		char file_buffer[HITCH_FILE_BUFFER_SIZE];
+		double threshold; //Nanoseconds
+		hitch_frame frames[HITCH_FRAMES];
+		uint64_t frame_amount; //Doesn't overflow even when the program runs for years
+		int frames_after; //Frames recorded after the first late frame, -1 when no frame is late
+		uint64_t first_late_frame;
+		int late_frames; //Since the first late frame
+
+		//The frames that the writer thread writes next
+		hitch_frame snapshot[HITCH_FRAMES];
+		int snapshot_frames, snapshot_late_frames;
+		uint64_t snapshot_hitch; //The number of the first late frame
+		bool snapshot_pending, stopping;
+		std::thread writer;
+		std::mutex mutex;
+		std::condition_variable changed;
+
+		//Statistics
+		uint64_t hitches, dropped_hitches;
+		int files;
+
+		void take_snapshot();
+		void write_snapshots();
+		bool write_snapshot();
+
+	public:
+		hitch_recorder_c();
+		~hitch_recorder_c();
+		void start(const char *directory, const double threshold, const double fps);
+		void stop();
+		void record(const sound_status &sound, const double song_position);
+		void print_statistics() const;
+};
+
+#endif
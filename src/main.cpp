@@ -2,22 +2,30 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <string>
 #include <GL/glew.h>
 #include <GL/glfw.h>
 #include "main.hpp"
 #include "visualizer.hpp"
+#include "headless_display.hpp"
+#include "offline.hpp"
+#include "bench.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
 
 /*
 
 	This program is supposed to visualize the spectrum of music
 	  with bars representing volumes of different frequencies
 	  and some squares representing volumes of bass and left and right channels
-	The program uses OpenGL 3.1 for graphics and FMOD for playing music and analyzing the spectrum
-	As FMOD does the actual analysis,
-	  this program does no FFT or anything else regarding spectrum analysis
-	  instead solely focusing on visualizing the data
+	The program uses OpenGL 3.1 for graphics and FMOD for playing music
+	The spectrum is analyzed with our own FFT from the samples that FMOD gives
+	  both channels are analyzed with a single vectorized FFT (see fft.cpp)
 	There is still one important thing to notice:
-	  FMOD gives the spectrum using linear scale
+	  the FFT gives the spectrum using linear scale
 	  whereas sound spectrum is better visualized using logarithmic scale,
 	  so this program still needs to do that conversion
 
@@ -25,6 +33,41 @@
 	This can be done by giving the file name/path as the first command line parameter
 	On Windows this can also be done by dragging a music file, that is in this same folder, on the executable file of this program
 
+	The song can also be analyzed without a window or sound much faster than realtime with --analyze
+	  --output file.txt writes the bar heights of every frame to the given file
+
+	The analysis results are saved in the cache directory and reused when the same song is played again
+	  --no-cache disables this
+
+	The variant of the analysis can be changed without recompiling:
+	  --bar-type 1 draws bars of constant width and --bar-type 2 draws every spectrum value as its own bar
+	  --no-smooth-spec and --no-smooth-bars turn off the smoothing of the spectrum and the bars
+	  --gpu-bars calculates the bar heights in the vertex shader from the spectrum, this doesn't use the cache
+
+	--headless renders without a window or an audio device (for example on servers with Mesa llvmpipe)
+	  it runs for one play through of the song or for --frames N frames
+	  --screenshot file.ppm saves the last frame, this works with the window too when --frames is given
+
+	The window can be resized and --fullscreen opens it in fullscreen with the desktop resolution
+	  --size WxH sets the size of the window or the size of the frames without a window
+
+	--export file.y4m renders the whole song to a video as fast as possible without a window
+	  the music is written next to it as a WAV file with the same name
+	  the video is Y4M or raw RGBA frames if the file name ends with .rgba
+
+	--metrics-csv file.csv writes how long the stages of every frame took in milliseconds
+	  the percentiles of the stages are printed at the end and when the process gets SIGUSR1
+
+	--metrics-socket path serves the frame counts, the frame times and the state of FMOD
+	  in the Prometheus text format on a Unix domain socket (not on Windows)
+
+	--hitch-dir directory writes the stages of the latest frames and the state of FMOD to a file there
+	  whenever a frame takes over --hitch-threshold X periods of the frame rate (2 by default)
+
+	--trace file.json records what every thread did and when and writes it for chrome://tracing or ui.perfetto.dev
+
+	--bench compares the speed of the optimized analysis code against the original code
+
 */
 
 inline void print_error(const char *message) {
@@ -35,40 +78,128 @@ inline void print_error(const char *message) {
 
 int main(int argc, char **argv) {
 	//Check program arguments and set played music file accordingly
-	if(argc < 2) {
+	const char *music_file = NULL;
+	bool offline = false; //Analyze the song without a window or sound
+	const char *output_file = NULL; //Where the offline analysis is written
+	bool use_cache = true; //Use the analysis results of earlier runs
+	analyzer_settings settings; //The variant of the analysis
+	bool headless = false; //Render without a window
+	int frame_limit = 0; //The amount of frames to render, 0 is unlimited
+	const char *screenshot_file = NULL; //Where the last frame is saved
+	const char *export_file = NULL; //Where the video is exported
+	const char *metrics_file = NULL; //Where the durations of the stages of every frame are written
+	const char *trace_file = NULL; //Where the timeline of the threads is written
+	const char *metrics_socket = NULL; //Where the metrics are served
+	const char *hitch_directory = NULL; //Where the frames around the late frames are written
+	double hitch_threshold = HITCH_THRESHOLD;
+	int width = WINDOW_WIDTH, height = WINDOW_HEIGHT; //The size of the window or the offscreen frames
+	bool fullscreen = false;
+	int frames_in_flight = FRAMES_IN_FLIGHT;
+	double fps = FPS; //The frame rate of the drawing
+	for(int i = 1; i < argc; i++) {
+		if(strcmp(argv[i], "--analyze") == 0) offline = true;
+		else if(strcmp(argv[i], "--bench") == 0) {
+			run_benchmark();
+			return 0;
+		}
+		else if(strcmp(argv[i], "--no-cache") == 0) use_cache = false;
+		else if(strcmp(argv[i], "--headless") == 0) headless = true;
+		else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frame_limit = std::max(atoi(argv[++i]), 0);
+		else if(strcmp(argv[i], "--screenshot") == 0 && i + 1 < argc) screenshot_file = argv[++i];
+		else if(strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+			if(sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+				width = WINDOW_WIDTH;
+				height = WINDOW_HEIGHT;
+			}
+		}
+		else if(strcmp(argv[i], "--fullscreen") == 0) fullscreen = true;
+		else if(strcmp(argv[i], "--fps") == 0 && i + 1 < argc) fps = std::min(std::max(atof(argv[++i]), MIN_TARGET_FPS), MAX_TARGET_FPS);
+		else if(strcmp(argv[i], "--frames-in-flight") == 0 && i + 1 < argc) frames_in_flight = std::min(std::max(atoi(argv[++i]), 1), MAX_FRAMES_IN_FLIGHT);
+		else if(strcmp(argv[i], "--export") == 0 && i + 1 < argc) {
+			export_file = argv[++i];
+			headless = true;
+		}
+		else if(strcmp(argv[i], "--metrics-csv") == 0 && i + 1 < argc) metrics_file = argv[++i];
+		else if(strcmp(argv[i], "--trace") == 0 && i + 1 < argc) trace_file = argv[++i];
+		else if(strcmp(argv[i], "--metrics-socket") == 0 && i + 1 < argc) metrics_socket = argv[++i];
+		else if(strcmp(argv[i], "--hitch-dir") == 0 && i + 1 < argc) hitch_directory = argv[++i];
+		else if(strcmp(argv[i], "--hitch-threshold") == 0 && i + 1 < argc) hitch_threshold = std::max(atof(argv[++i]), 1.0);
+		else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc) output_file = argv[++i];
+		else if(strcmp(argv[i], "--bar-type") == 0 && i + 1 < argc) settings.bar_type = atoi(argv[++i]) == 2 ? 2 : 1;
+		else if(strcmp(argv[i], "--smooth-spec") == 0) settings.smooth_spectrum = true;
+		else if(strcmp(argv[i], "--no-smooth-spec") == 0) settings.smooth_spectrum = false;
+		else if(strcmp(argv[i], "--smooth-bars") == 0) settings.smooth_bars = true;
+		else if(strcmp(argv[i], "--no-smooth-bars") == 0) settings.smooth_bars = false;
+		else if(strcmp(argv[i], "--gpu-bars") == 0) settings.gpu_bars = true;
+		else music_file = argv[i];
+	}
+	if(!music_file) {
 		std::cout << "No music file specified. Playing default song:" << std::endl;
 		std::cout << "  Horizon by Geoplex" << std::endl;
 		std::cout << "  Get original version from http://www.newgrounds.com/audio/listen/520387" << std::endl;
 		std::cout << "You can play other songs by giving their file name/path as the first command line parameter." << std::endl;
 		std::cout << std::endl;
+		music_file = "520387_Horizon_short.mp3";
+	}
+
+	//The offline analysis doesn't need a window
+	//The bars are always calculated on the CPU there
+	if(offline) {
+		settings.gpu_bars = false;
+		run_offline_analysis(music_file, output_file, settings);
+		return 0;
+	}
+
+	//The durations of the stages of the frames and the timeline of the threads
+	if(trace_file) tracer.start();
+	profiler_c::install_signal_handler();
+	if(metrics_file && !profiler.open_csv(metrics_file)) std::cerr << "Couldn't open " << metrics_file << " for writing!" << std::endl;
+
+	//The frames are rendered either to a window or offscreen
+	const trace_time display_start_time = std::chrono::steady_clock::now();
+	display_c *display;
+	if(headless) {
+		display = new headless_display_c(width, height);
+		if(!display->is_open()) print_error("Couldn't create a headless OpenGL context!");
+		std::cout << "Using OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+		std::cout << "Rendering with: " << glGetString(GL_RENDERER) << std::endl;
 	}
-	const char *music_file = argc < 2 ? "520387_Horizon_short.mp3" : argv[1];
-
-	//Init GLFW and open window
-	if(glfwInit() == GL_FALSE) print_error("Couldn't initialize GLFW!");
-	glfwOpenWindowHint(GLFW_WINDOW_NO_RESIZE, GL_TRUE);
-	glfwOpenWindowHint(GLFW_FSAA_SAMPLES, 0);
-	if(glfwOpenWindow(WINDOW_WIDTH, WINDOW_HEIGHT, 8, 8, 8, 8, 0, 0, GLFW_WINDOW) == GL_FALSE) print_error("Couldn't open window!");
-
-	//Set program window in the middle of the screen and some other settings
-	GLFWvidmode desktop_resolution;
-	glfwGetDesktopMode(&desktop_resolution);
-	glfwSetWindowPos((desktop_resolution.Width - WINDOW_WIDTH) / 2, (desktop_resolution.Height - WINDOW_HEIGHT) / 3);
-	glfwSetWindowTitle("FMOD music spectrum visualizer");
-	glfwSwapInterval(1); //vsync
-	glfwEnable(GLFW_MOUSE_CURSOR);
-
-	//Check some values
-	std::cout << "Using OpenGL version: " << glGetString(GL_VERSION) << std::endl;
-	std::cout << "Rendering with: " << glGetString(GL_RENDERER) << std::endl;
-	std::cout << (glfwGetWindowParam(GLFW_ACCELERATED) ? "Hardware accelerated window succesfully opened!" : "Couldn't get hardware acceleration!") << std::endl;
-	std::cout << "Color bits: " << (glfwGetWindowParam(GLFW_RED_BITS) + glfwGetWindowParam(GLFW_GREEN_BITS) + glfwGetWindowParam(GLFW_BLUE_BITS) + glfwGetWindowParam(GLFW_ALPHA_BITS)) << " / 32" << std::endl;
-	std::cout << "Depth bits: " << glfwGetWindowParam(GLFW_DEPTH_BITS) << " / 0" << std::endl;
-	std::cout << "Stencil bits: " << glfwGetWindowParam(GLFW_STENCIL_BITS) << " / 0" << std::endl;
-	std::cout << "Multisampling: " << glfwGetWindowParam(GLFW_FSAA_SAMPLES) << " / 0" << std::endl;
-
-	//Init GLEW and check OpenGL version support
-	if(glewInit() != GLEW_OK) print_error("Couldn't initialize GLEW!");
+	else {
+		//Init GLFW and open window
+		if(glfwInit() == GL_FALSE) print_error("Couldn't initialize GLFW!");
+		//The window can be resized, the fullscreen mode uses the desktop resolution
+		GLFWvidmode desktop_resolution;
+		glfwGetDesktopMode(&desktop_resolution);
+		if(fullscreen) {
+			width = desktop_resolution.Width;
+			height = desktop_resolution.Height;
+		}
+		glfwOpenWindowHint(GLFW_FSAA_SAMPLES, 0);
+		if(glfwOpenWindow(width, height, 8, 8, 8, 8, 0, 0, fullscreen ? GLFW_FULLSCREEN : GLFW_WINDOW) == GL_FALSE) print_error("Couldn't open window!");
+
+		//Set program window in the middle of the screen and some other settings
+		if(!fullscreen) glfwSetWindowPos((desktop_resolution.Width - width) / 2, (desktop_resolution.Height - height) / 3);
+		glfwSetWindowTitle("FMOD music spectrum visualizer");
+		glfwSwapInterval(1); //vsync
+		glfwEnable(GLFW_MOUSE_CURSOR);
+
+		//Check some values
+		std::cout << "Using OpenGL version: " << glGetString(GL_VERSION) << std::endl;
+		std::cout << "Rendering with: " << glGetString(GL_RENDERER) << std::endl;
+		std::cout << (glfwGetWindowParam(GLFW_ACCELERATED) ? "Hardware accelerated window succesfully opened!" : "Couldn't get hardware acceleration!") << std::endl;
+		std::cout << "Color bits: " << (glfwGetWindowParam(GLFW_RED_BITS) + glfwGetWindowParam(GLFW_GREEN_BITS) + glfwGetWindowParam(GLFW_BLUE_BITS) + glfwGetWindowParam(GLFW_ALPHA_BITS)) << " / 32" << std::endl;
+		std::cout << "Depth bits: " << glfwGetWindowParam(GLFW_DEPTH_BITS) << " / 0" << std::endl;
+		std::cout << "Stencil bits: " << glfwGetWindowParam(GLFW_STENCIL_BITS) << " / 0" << std::endl;
+		std::cout << "Multisampling: " << glfwGetWindowParam(GLFW_FSAA_SAMPLES) << " / 0" << std::endl;
+
+		//Init GLEW
+		if(glewInit() != GLEW_OK) print_error("Couldn't initialize GLEW!");
+		display = new window_display_c();
+	}
+
+	if(tracer.is_enabled()) tracer.add("open_display", display_start_time, std::chrono::steady_clock::now());
+
+	//Check OpenGL version support
 	if(!glewIsSupported("GL_VERSION_3_1")) std::cerr << "WARNING: OpenGL 3.1 not supported!" << std::endl;
 
 	//OpenGL settings
@@ -77,11 +208,32 @@ int main(int argc, char **argv) {
 	glClearColor(0.0, 0.0, 0.0, 1.0);
 
 	//Wrapped inside this block so that visualizer gets automatically deleted
-	{
-		visualizer_c visualizer(music_file);
-		visualizer.run();
+	const trace_time visualizer_start_time = std::chrono::steady_clock::now();
+	if(export_file) {
+		//The WAV file gets the name of the video file
+		std::string wav_file(export_file);
+		const size_t extension = wav_file.find_last_of('.');
+		if(extension != std::string::npos && wav_file.find_first_of("/\\", extension) == std::string::npos) wav_file.erase(extension);
+		wav_file+= ".wav";
+
+		visualizer_c visualizer(*display, music_file, use_cache, settings, OUTPUT_WAVWRITER_NRT, wav_file.c_str(), frames_in_flight);
+		if(tracer.is_enabled()) tracer.add("create_visualizer", visualizer_start_time, std::chrono::steady_clock::now());
+		visualizer.export_video(export_file);
+		std::cout << "The music was written to " << wav_file << std::endl;
+	}
+	else {
+		visualizer_c visualizer(*display, music_file, use_cache, settings, headless ? OUTPUT_NOSOUND : OUTPUT_DEVICE, NULL, frames_in_flight, fps);
+		if(tracer.is_enabled()) tracer.add("create_visualizer", visualizer_start_time, std::chrono::steady_clock::now());
+		if(headless && frame_limit == 0) frame_limit = visualizer.get_song_frames();
+		if(hitch_directory) visualizer.record_hitches(hitch_directory, hitch_threshold);
+		if(metrics_socket && !visualizer.serve_metrics(metrics_socket)) std::cerr << "Couldn't serve the metrics on " << metrics_socket << std::endl;
+		visualizer.run(frame_limit, screenshot_file);
 	}
+	delete display;
+
+	if(!headless) glfwTerminate();
 
-	glfwTerminate();
+	//All the other threads have stopped now
+	if(trace_file && !tracer.write(trace_file)) std::cerr << "Couldn't write the trace to " << trace_file << std::endl;
 	return 0;
 }
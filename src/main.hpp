@@ -7,4 +7,6 @@
 #define WINDOW_WIDTH 1024
 #define WINDOW_HEIGHT 429
 
+#define FPS 60.0 //Frames per second
+
 #endif
@@ -0,0 +1,220 @@
+/** metrics_server.cpp **/
+
+#include <iostream>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+#include <algorithm>
+#include "metrics_server.hpp"
+#include "profiler.hpp"
+
+#ifndef _WIN32
+	#include <sys/socket.h>
+	#include <sys/un.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+	#include <poll.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+	#define MSG_NOSIGNAL 0
+#endif
+
+//Appends to the buffer like snprintf, the rest is cut off when the buffer is full
+static void append(char *buffer, const int size, int &length, const char *format, ...) {
+	if(length >= size - 1) return;
+	va_list arguments;
+	va_start(arguments, format);
+	const int written = vsnprintf(buffer + length, size - length, format, arguments);
+	va_end(arguments);
+	if(written > 0) length = std::min(length + written, size - 1);
+}
+
+metrics_server_c::metrics_server_c():
+	listener(-1), running(false),
+	frames(0), missed_deadlines(0), dropped_deadlines(0), song_position(0),
+	av_latency(0), output_latency(0), display_latency(0),
+	dsp_usage(0), stream_usage(0), update_usage(0), total_usage(0),
+	open_state(0), percent_buffered(0), memory_used(0), memory_max(0),
+	starving(false), disk_busy(false) {}
+
+metrics_server_c::~metrics_server_c() {
+	stop();
+}
+
+//Called at the end of every frame, only stores the values
+void metrics_server_c::publish(const int frames, const int missed_deadlines, const int dropped_deadlines, const double song_position, const sound_status &sound) {
+	this->frames.store(frames, std::memory_order_relaxed);
+	this->missed_deadlines.store(missed_deadlines, std::memory_order_relaxed);
+	this->dropped_deadlines.store(dropped_deadlines, std::memory_order_relaxed);
+	this->song_position.store(song_position, std::memory_order_relaxed);
+	dsp_usage.store(sound.dsp_usage, std::memory_order_relaxed);
+	stream_usage.store(sound.stream_usage, std::memory_order_relaxed);
+	update_usage.store(sound.update_usage, std::memory_order_relaxed);
+	total_usage.store(sound.total_usage, std::memory_order_relaxed);
+	open_state.store(sound.open_state, std::memory_order_relaxed);
+	percent_buffered.store(sound.percent_buffered, std::memory_order_relaxed);
+	memory_used.store(sound.memory_used, std::memory_order_relaxed);
+	memory_max.store(sound.memory_max, std::memory_order_relaxed);
+	starving.store(sound.starving, std::memory_order_relaxed);
+	disk_busy.store(sound.disk_busy, std::memory_order_relaxed);
+}
+
+//The latencies of the audio/visual sync, see visualizer_c::prepare_next_frame
+void metrics_server_c::publish_latency(const double av_latency, const double output_latency, const double display_latency) {
+	this->av_latency.store(av_latency, std::memory_order_relaxed);
+	this->output_latency.store(output_latency, std::memory_order_relaxed);
+	this->display_latency.store(display_latency, std::memory_order_relaxed);
+}
+
+//Writes the metrics in the Prometheus text format and returns the length
+int metrics_server_c::write_metrics(char *buffer, const int size) const {
+	int length = 0;
+	append(buffer, size, length, "# HELP visualizer_frames_total Frames rendered.\n# TYPE visualizer_frames_total counter\nvisualizer_frames_total %llu\n",
+		(unsigned long long)frames.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_missed_deadlines_total Frames that ended after their deadline.\n# TYPE visualizer_missed_deadlines_total counter\nvisualizer_missed_deadlines_total %llu\n",
+		(unsigned long long)missed_deadlines.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_dropped_deadlines_total Deadlines skipped after late frames.\n# TYPE visualizer_dropped_deadlines_total counter\nvisualizer_dropped_deadlines_total %llu\n",
+		(unsigned long long)dropped_deadlines.load(std::memory_order_relaxed));
+
+	append(buffer, size, length, "# HELP visualizer_song_position_seconds Position in the song of the sound that the shown frame was drawn from.\n# TYPE visualizer_song_position_seconds gauge\nvisualizer_song_position_seconds %.3f\n",
+		song_position.load(std::memory_order_relaxed));
+
+	//The audio/visual sync
+	append(buffer, size, length, "# HELP visualizer_av_latency_seconds How much later the latest frame is shown than its sound is heard, negative when before.\n# TYPE visualizer_av_latency_seconds gauge\nvisualizer_av_latency_seconds %.6f\n",
+		av_latency.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_output_latency_seconds Time from FMOD mixing a sample to it being heard.\n# TYPE visualizer_output_latency_seconds gauge\nvisualizer_output_latency_seconds %.6f\n",
+		output_latency.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_display_latency_seconds Time from preparing a frame to showing it.\n# TYPE visualizer_display_latency_seconds gauge\nvisualizer_display_latency_seconds %.6f\n",
+		display_latency.load(std::memory_order_relaxed));
+
+	//The frame times of the whole run
+	const histogram_c &frame_histogram = profiler.get_histogram(STAGE_FRAME);
+	append(buffer, size, length, "# HELP visualizer_frame_seconds Time from the start of a frame to the start of the next one.\n# TYPE visualizer_frame_seconds summary\n");
+	const double quantiles[] = {0.5, 0.95, 0.99};
+	for(int i = 0; i < 3; i++) {
+		append(buffer, size, length, "visualizer_frame_seconds{quantile=\"%g\"} %.9f\n", quantiles[i], frame_histogram.get_percentile(quantiles[i] * 100.0) / 1000000000.0);
+	}
+	append(buffer, size, length, "visualizer_frame_seconds_sum %.9f\nvisualizer_frame_seconds_count %llu\n",
+		frame_histogram.get_sum() / 1000000000.0, (unsigned long long)frame_histogram.get_count());
+
+	//FMOD
+	append(buffer, size, length, "# HELP visualizer_fmod_cpu_percent CPU usage of FMOD in percents of a core.\n# TYPE visualizer_fmod_cpu_percent gauge\n");
+	append(buffer, size, length, "visualizer_fmod_cpu_percent{part=\"dsp\"} %g\nvisualizer_fmod_cpu_percent{part=\"stream\"} %g\n",
+		dsp_usage.load(std::memory_order_relaxed), stream_usage.load(std::memory_order_relaxed));
+	append(buffer, size, length, "visualizer_fmod_cpu_percent{part=\"update\"} %g\nvisualizer_fmod_cpu_percent{part=\"total\"} %g\n",
+		update_usage.load(std::memory_order_relaxed), total_usage.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_fmod_stream_open_state FMOD_OPENSTATE of the music stream, 0 is ready.\n# TYPE visualizer_fmod_stream_open_state gauge\nvisualizer_fmod_stream_open_state %d\n",
+		open_state.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_fmod_stream_buffered_percent How full the buffer of the music stream is.\n# TYPE visualizer_fmod_stream_buffered_percent gauge\nvisualizer_fmod_stream_buffered_percent %d\n",
+		percent_buffered.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_fmod_stream_starving 1 when the music stream runs out of data.\n# TYPE visualizer_fmod_stream_starving gauge\nvisualizer_fmod_stream_starving %d\n",
+		starving.load(std::memory_order_relaxed) ? 1 : 0);
+	append(buffer, size, length, "# HELP visualizer_fmod_stream_disk_busy 1 when the music stream is reading the disk.\n# TYPE visualizer_fmod_stream_disk_busy gauge\nvisualizer_fmod_stream_disk_busy %d\n",
+		disk_busy.load(std::memory_order_relaxed) ? 1 : 0);
+	append(buffer, size, length, "# HELP visualizer_fmod_memory_bytes Memory allocated by FMOD.\n# TYPE visualizer_fmod_memory_bytes gauge\nvisualizer_fmod_memory_bytes %d\n",
+		memory_used.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_fmod_memory_max_bytes The most memory that FMOD has allocated.\n# TYPE visualizer_fmod_memory_max_bytes gauge\nvisualizer_fmod_memory_max_bytes %d\n",
+		memory_max.load(std::memory_order_relaxed));
+	append(buffer, size, length, "# HELP visualizer_fmod_errors_total FMOD calls that returned an error.\n# TYPE visualizer_fmod_errors_total counter\nvisualizer_fmod_errors_total %u\n",
+		sound_system_c::get_error_count());
+	return length;
+}
+
+#ifndef _WIN32
+	//Listens on the socket at path, an old socket there is replaced but any other file is left alone
+	bool metrics_server_c::start(const char *path) {
+		if(listener >= 0) return true;
+		sockaddr_un address;
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if(strlen(path) >= sizeof(address.sun_path)) {
+			std::cerr << "The path of the metrics socket is too long: " << path << std::endl;
+			return false;
+		}
+		strcpy(address.sun_path, path);
+
+		struct stat existing;
+		if(lstat(path, &existing) == 0) {
+			if(!S_ISSOCK(existing.st_mode)) {
+				std::cerr << "Not replacing " << path << " with the metrics socket as it is not a socket" << std::endl;
+				return false;
+			}
+			unlink(path);
+		}
+
+		listener = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(listener < 0) return false;
+		if(bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 4) != 0) {
+			close(listener);
+			listener = -1;
+			return false;
+		}
+		this->path = path;
+		running = true;
+		thread = std::thread(&metrics_server_c::run, this);
+		return true;
+	}
+
+	void metrics_server_c::stop() {
+		if(listener < 0) return;
+		running = false;
+		thread.join();
+		close(listener);
+		listener = -1;
+		unlink(path.c_str());
+	}
+
+	//The thread of the server, answers one connection at a time
+	void metrics_server_c::run() {
+		tracer.set_thread_name("metrics");
+		while(running) {
+			pollfd listening = {listener, POLLIN, 0};
+			if(poll(&listening, 1, METRICS_POLL_INTERVAL) <= 0) continue;
+			const int connection = accept(listener, NULL, NULL);
+			if(connection < 0) continue;
+			serve(connection);
+			close(connection);
+		}
+	}
+
+	//Reads the HTTP request if there is one and answers with the metrics whatever was asked
+	//  so that both HTTP clients and plain socket readers like socat get them
+	void metrics_server_c::serve(const int connection) {
+		scoped_trace_c trace("scrape");
+		char request[1024];
+		int request_length = 0;
+		while(request_length < (int)sizeof(request) - 1) {
+			pollfd readable = {connection, POLLIN, 0};
+			if(poll(&readable, 1, METRICS_POLL_INTERVAL) <= 0) break;
+			const ssize_t received = recv(connection, request + request_length, sizeof(request) - 1 - request_length, 0);
+			if(received <= 0) break;
+			request_length+= received;
+			request[request_length] = '\0';
+			if(strstr(request, "\r\n\r\n")) break;
+		}
+
+		const int body_length = write_metrics(response, METRICS_RESPONSE_SIZE);
+		char header[128];
+		const int header_length = snprintf(header, sizeof(header),
+			"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %d\r\n\r\n", body_length);
+		const char *parts[2] = {header, response};
+		const int lengths[2] = {header_length, body_length};
+		for(int i = 0; i < 2; i++) {
+			for(int sent = 0; sent < lengths[i];) {
+				const ssize_t result = send(connection, parts[i] + sent, lengths[i] - sent, MSG_NOSIGNAL);
+				if(result <= 0) return;
+				sent+= result;
+			}
+		}
+	}
+#else
+	bool metrics_server_c::start(const char *path) {
+		std::cerr << "WARNING: The metrics socket is not supported on Windows" << std::endl;
+		return false;
+	}
+
+	void metrics_server_c::stop() {}
+	void metrics_server_c::run() {}
+	void metrics_server_c::serve(const int connection) {}
+#endif
@@ -0,0 +1,58 @@
+/** metrics_server.hpp **/
+
+#ifndef METRICS_SERVER_HPP
+#define METRICS_SERVER_HPP
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include "sound_system.hpp"
+
+//The largest response, the metrics are written into a buffer of this size so a scrape doesn't allocate
+#define METRICS_RESPONSE_SIZE 8192
+
+//How often the thread checks whether it should stop in milliseconds
+#define METRICS_POLL_INTERVAL 200
+
+/*
+	Serves the health of the visualizer in the Prometheus text format on a Unix domain socket
+	  for example: curl --unix-socket /tmp/visualizer.sock http://localhost/metrics
+	The render thread publishes the counters with atomic stores at the end of every frame
+	  and the thread of the server only reads them, so a scrape never makes a frame wait
+	The percentiles of the frame times come from the histograms of the profiler
+	Not available on Windows
+*/
+class metrics_server_c {
+	private:
+		metrics_server_c(const metrics_server_c &obj); //Copy constructor
+		metrics_server_c &operator=(const metrics_server_c &obj); //Assign operator
+
+		std::string path;
+		int listener; //-1 when not serving
+		std::thread thread;
+		std::atomic<bool> running;
+
+		//Published by the render thread
+		std::atomic<uint64_t> frames, missed_deadlines, dropped_deadlines;
+		std::atomic<double> song_position;
+		std::atomic<double> av_latency, output_latency, display_latency; //Seconds
+		std::atomic<float> dsp_usage, stream_usage, update_usage, total_usage;
+		std::atomic<int> open_state, percent_buffered, memory_used, memory_max;
+		std::atomic<bool> starving, disk_busy;
+
+		char response[METRICS_RESPONSE_SIZE];
+
+		void run();
+		void serve(const int connection);
+		int write_metrics(char *buffer, const int size) const;
+
+	public:
+		metrics_server_c();
+		~metrics_server_c();
+		bool start(const char *path);
+		void stop();
+		void publish(const int frames, const int missed_deadlines, const int dropped_deadlines, const double song_position, const sound_status &sound);
+		void publish_latency(const double av_latency, const double output_latency, const double display_latency);
+};
+
+#endif
@@ -0,0 +1,57 @@
+/** offline.cpp **/
+
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include "offline.hpp"
+#include "analyzer.hpp"
+#include "allocation_counter.hpp"
+#include "main.hpp"
+
+//Writes one frame per line: time, bass, left, right, sound and then the heights of the bars
+void write_frame(std::ofstream &output, const analyzer_c &analyzer, const int frame) {
+	output << frame / FPS << ' ' << analyzer.get_bass_sum() << ' ' << analyzer.get_left_sum() << ' ' << analyzer.get_right_sum() << ' ' << analyzer.get_sound_sum();
+	const float *bar_heights = analyzer.get_bar_heights();
+	for(int i = 0; i < analyzer.get_bar_amount(); i++) output << ' ' << bar_heights[i];
+	output << '\n';
+}
+
+//output_name may be NULL in which case only the speed of the analysis is measured
+void run_offline_analysis(const char *song_name, const char *output_name, const analyzer_settings &settings) {
+	sound_system_c sound_system(song_name, OUTPUT_NRT);
+	analyzer_c analyzer(settings);
+
+	std::ofstream output;
+	if(output_name) {
+		output.open(output_name);
+		if(!output.good()) {
+			std::cerr << "Couldn't open " << output_name << " for writing!" << std::endl;
+			return;
+		}
+	}
+
+	//The amount of music in one frame
+	const unsigned int samples_per_frame = OUTPUTRATE / FPS;
+
+	const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+	int frames = 0;
+	allocation_checker_c allocation_checker;
+
+	//Every update mixes one more block of the music
+	sound_system.play_music();
+	while(sound_system.is_playing()) {
+		sound_system.update();
+		while(sound_system.get_available_samples() >= samples_per_frame) {
+			analyzer.analyze(sound_system, samples_per_frame);
+			if(output_name) write_frame(output, analyzer, frames);
+			frames++;
+			allocation_checker.end_frame();
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+	std::cout << "Analyzed " << frames << " frames (" << frames / FPS << " seconds of music) in " << seconds << " seconds" << std::endl;
+	if(seconds > 0.0) {
+		std::cout << "  " << frames / seconds << " frames per second, " << frames / FPS / seconds << " times realtime" << std::endl;
+	}
+}
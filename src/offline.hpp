@@ -0,0 +1,15 @@
+/** offline.hpp **/
+
+#ifndef OFFLINE_HPP
+#define OFFLINE_HPP
+
+/*
+	Offline analysis runs the whole analysis of a song without a window or an audio device
+	FMOD mixes the music as fast as the analysis can take it and one frame is analyzed per 1 / FPS seconds of music
+	The bar heights and square sizes of every frame can be written to a text file
+*/
+struct analyzer_settings;
+
+void run_offline_analysis(const char *song_name, const char *output_name, const analyzer_settings &settings);
+
+#endif
@@ -0,0 +1,131 @@
+/** profiler.cpp **/
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <csignal>
+#include "profiler.hpp"
+
+profiler_c profiler;
+
+//The names of the stages in the printed table and in the CSV file
+static const char *const stage_names[STAGE_AMOUNT] = {
+	"analysis", "fetch", "smoothing", "bars", "sound_update", "pipeline_wait", "prepare",
+	"draw_rects", "draw_squares", "draw_gpu_bars", "present", "swap", "pacing", "frame"
+};
+
+//Set by the signal handler and handled at the end of the next frame
+static std::atomic<bool> print_requested(false);
+
+static void request_print(int) {
+	print_requested.store(true);
+}
+
+histogram_c::histogram_c(): count(0), sum(0), max(0) {
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++) counts[i].store(0, std::memory_order_relaxed);
+}
+
+//The values below HISTOGRAM_SUB_BUCKETS have their own buckets
+//  the rest are split by the highest bit and the HISTOGRAM_SUB_BITS bits after it
+int histogram_c::bucket(const uint64_t value) {
+	if(value < HISTOGRAM_SUB_BUCKETS) return value;
+	const uint64_t v = value < ((uint64_t)2 << HISTOGRAM_MAX_BITS) ? value : ((uint64_t)2 << HISTOGRAM_MAX_BITS) - 1;
+	int bits = HISTOGRAM_SUB_BITS;
+	while(v >> (bits + 1)) bits++;
+	return (bits - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_BUCKETS + (int)(v >> (bits - HISTOGRAM_SUB_BITS)) - HISTOGRAM_SUB_BUCKETS;
+}
+
+//The value in the middle of the bucket
+uint64_t histogram_c::bucket_value(const int index) {
+	if(index < HISTOGRAM_SUB_BUCKETS) return index;
+	const int shift = index / HISTOGRAM_SUB_BUCKETS - 1;
+	const uint64_t low = (uint64_t)(HISTOGRAM_SUB_BUCKETS + index % HISTOGRAM_SUB_BUCKETS) << shift;
+	return low + ((uint64_t)1 << shift) / 2;
+}
+
+void histogram_c::record(const uint64_t value) {
+	counts[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+	count.fetch_add(1, std::memory_order_relaxed);
+	sum.fetch_add(value, std::memory_order_relaxed);
+	uint64_t previous = max.load(std::memory_order_relaxed);
+	while(value > previous && !max.compare_exchange_weak(previous, value, std::memory_order_relaxed));
+}
+
+//The value that percentile percents of the values are at most, 0 if there are no values
+uint64_t histogram_c::get_percentile(const double percentile) const {
+	const uint64_t total = get_count();
+	if(total == 0) return 0;
+	const uint64_t wanted = (uint64_t)(total * percentile / 100.0 + 0.5);
+	uint64_t sum = 0;
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+		sum+= counts[i].load(std::memory_order_relaxed);
+		if(sum >= wanted && sum > 0) return std::min(bucket_value(i), get_max());
+	}
+	return get_max();
+}
+
+profiler_c::profiler_c(): frames(0) {
+	for(int i = 0; i < STAGE_AMOUNT; i++) {
+		frame_times[i].store(0, std::memory_order_relaxed);
+		last_frame_times[i] = 0;
+	}
+}
+
+void profiler_c::record(const profile_stage stage, const uint64_t nanoseconds) {
+	histograms[stage].record(nanoseconds);
+	frame_times[stage].fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+//Every frame is written as a row of milliseconds from now on
+bool profiler_c::open_csv(const char *file_name) {
+	csv.open(file_name);
+	if(!csv.is_open()) return false;
+	csv << "frame";
+	for(int i = 0; i < STAGE_AMOUNT; i++) csv << ',' << stage_names[i];
+	csv << '\n' << std::fixed << std::setprecision(4);
+	return true;
+}
+
+//Called after the last stage of the frame
+//The analysis thread may be in the middle of its stages, those go to the frame when they end
+void profiler_c::end_frame() {
+	frames++;
+	for(int i = 0; i < STAGE_AMOUNT; i++) last_frame_times[i] = frame_times[i].exchange(0, std::memory_order_relaxed);
+	if(csv.is_open()) {
+		csv << frames;
+		for(int i = 0; i < STAGE_AMOUNT; i++) csv << ',' << last_frame_times[i] / 1000000.0;
+		csv << '\n';
+	}
+	if(print_requested.exchange(false)) print();
+}
+
+const char *profiler_c::get_stage_name(const profile_stage stage) {
+	return stage_names[stage];
+}
+
+void print_histogram_header(const char *title) {
+	std::cout << std::left << std::setw(16) << title << std::right << std::setw(10) << "count" << std::setw(10) << "p50"
+		<< std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+}
+
+void print_histogram_row(const char *name, const histogram_c &histogram) {
+	std::cout << std::left << std::setw(16) << name << std::right << std::setw(10) << histogram.get_count() << std::fixed << std::setprecision(3)
+		<< std::setw(10) << histogram.get_percentile(50) / 1000000.0 << std::setw(10) << histogram.get_percentile(95) / 1000000.0
+		<< std::setw(10) << histogram.get_percentile(99) / 1000000.0 << std::setw(10) << histogram.get_max() / 1000000.0 << std::endl;
+	std::cout.unsetf(std::ios::floatfield);
+	std::cout << std::setprecision(6);
+}
+
+void profiler_c::print() const {
+	print_histogram_header("Stage (ms)");
+	for(int i = 0; i < STAGE_AMOUNT; i++) {
+		if(histograms[i].get_count() > 0) print_histogram_row(stage_names[i], histograms[i]);
+	}
+}
+
+//kill -USR1 prints the percentiles while the program is running
+void profiler_c::install_signal_handler() {
+	#ifdef SIGUSR1
+		signal(SIGUSR1, request_print);
+	#endif
+}
@@ -0,0 +1,122 @@
+/** profiler.hpp **/
+
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <stdint.h>
+#include "trace.hpp"
+
+//The histograms have HISTOGRAM_SUB_BUCKETS buckets for every power of two of nanoseconds
+//  so every value is known to about 6 % and the largest value is about half an hour
+#define HISTOGRAM_SUB_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_MAX_BITS 40
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) * HISTOGRAM_SUB_BUCKETS)
+
+//The measured parts of a frame
+//The analysis ones are measured in the analysis thread when playing in realtime
+enum profile_stage {
+	STAGE_ANALYSIS, //All of the analysis including the cache
+	STAGE_FETCH, //Moving the samples to the analysis window and the FFT
+	STAGE_SMOOTHING, //The smoothing of the spectrum and the sums for the squares, done in one go
+	STAGE_BARS, //The bar heights from the spectrum
+	STAGE_SOUND_UPDATE,
+	STAGE_PIPELINE_WAIT, //Waiting for the GPU to finish an earlier frame
+	STAGE_PREPARE, //Writing the batches of the frame
+	STAGE_DRAW_RECTS, //The draw commands of the rectangle layers
+	STAGE_DRAW_SQUARES,
+	STAGE_DRAW_GPU_BARS,
+	STAGE_PRESENT, //Drawing the feedback texture to the screen
+	STAGE_SWAP,
+	STAGE_PACING, //Waiting for the next frame
+	STAGE_FRAME, //The whole frame
+	STAGE_AMOUNT
+};
+
+/*
+	A histogram of durations in nanoseconds that any thread can add to without locks
+	The buckets grow exponentially like in HDR histograms so both short and long durations are accurate
+*/
+class histogram_c {
+	private:
+		histogram_c(const histogram_c &obj); //Copy constructor
+		histogram_c &operator=(const histogram_c &obj); //Assign operator
+
+		std::atomic<uint32_t> counts[HISTOGRAM_BUCKETS];
+		std::atomic<uint64_t> count, sum, max;
+
+		static int bucket(const uint64_t value);
+		static uint64_t bucket_value(const int index);
+
+	public:
+		histogram_c();
+		void record(const uint64_t value);
+		uint64_t get_count() const { return count.load(std::memory_order_relaxed); }
+		uint64_t get_sum() const { return sum.load(std::memory_order_relaxed); }
+		uint64_t get_max() const { return max.load(std::memory_order_relaxed); }
+		uint64_t get_percentile(const double percentile) const;
+};
+
+//The tables of percentiles in milliseconds that the profilers print
+void print_histogram_header(const char *title);
+void print_histogram_row(const char *name, const histogram_c &histogram);
+
+/*
+	Collects the durations of the stages of the frames
+	Every stage has a histogram for the percentiles and a sum for the current frame,
+	  which is kept for the hitch recorder and written as a row of the CSV file when the frame ends
+	The percentiles are printed when the program ends or when the process gets SIGUSR1
+*/
+class profiler_c {
+	private:
+		profiler_c(const profiler_c &obj); //Copy constructor
+		profiler_c &operator=(const profiler_c &obj); //Assign operator
+
+		histogram_c histograms[STAGE_AMOUNT];
+		std::atomic<uint64_t> frame_times[STAGE_AMOUNT]; //Nanoseconds in the current frame
+		uint64_t last_frame_times[STAGE_AMOUNT]; //Nanoseconds in the frame that ended last
+		std::ofstream csv;
+		int frames;
+
+	public:
+		profiler_c();
+		void record(const profile_stage stage, const uint64_t nanoseconds);
+		bool open_csv(const char *file_name);
+		void end_frame();
+		void print() const;
+		const histogram_c &get_histogram(const profile_stage stage) const { return histograms[stage]; }
+		uint64_t get_frame_time(const profile_stage stage) const { return last_frame_times[stage]; }
+		static const char *get_stage_name(const profile_stage stage);
+		static void install_signal_handler();
+};
+
+//The profiler of the program
+extern profiler_c profiler;
+
+//Measures the time from its construction to its destruction or to stop
+//The stage is also an event of the trace when tracing
+class scoped_timer_c {
+	private:
+		scoped_timer_c(const scoped_timer_c &obj); //Copy constructor
+		scoped_timer_c &operator=(const scoped_timer_c &obj); //Assign operator
+
+		const profile_stage stage;
+		const trace_time start;
+		bool running;
+
+	public:
+		scoped_timer_c(const profile_stage stage): stage(stage), start(std::chrono::steady_clock::now()), running(true) {}
+		~scoped_timer_c() { stop(); }
+		void stop() {
+			if(!running) return;
+			running = false;
+			const trace_time end = std::chrono::steady_clock::now();
+			profiler.record(stage, std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+			if(tracer.is_enabled()) tracer.add(profiler_c::get_stage_name(stage), start, end);
+		}
+};
+
+#endif
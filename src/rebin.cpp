@@ -0,0 +1,157 @@
+/** rebin.cpp **/
+
+#include <cmath>
+#include <algorithm>
+#include "rebin.hpp"
+#include "simd.hpp"
+
+rebin_matrix_c::rebin_matrix_c(const int columns):
+	columns(columns), rows(0), row_offset(NULL), row_column(NULL), weights(NULL) {}
+
+rebin_matrix_c::~rebin_matrix_c() {
+	free();
+}
+
+void rebin_matrix_c::free() {
+	delete [] row_offset;
+	delete [] row_column;
+	if(weights) simd_free(weights);
+	row_offset = NULL;
+	row_column = NULL;
+	weights = NULL;
+	rows = 0;
+}
+
+//Starts a new row, the rows are added in order
+void rebin_matrix_c::begin_row() {
+	building.push_back(std::vector<std::pair<int, float> >());
+}
+
+//Adds a weight to the current row, weights to the same column are summed
+void rebin_matrix_c::add_weight(const int column, const float weight) {
+	if(weight != 0.0f && column >= 0 && column < columns) building.back().push_back(std::make_pair(column, weight));
+}
+
+//Adds the columns from start to end to the current row
+//The columns are treated as having a width of 1 so the partially covered columns get partial weights
+void rebin_matrix_c::add_range(const float start, const float end) {
+	for(int column = floor(start); column < end; column++) {
+		add_weight(column, std::min(end, column + 1.0f) - std::max(start, (float)column));
+	}
+}
+
+//Packs the built rows to the aligned storage
+void rebin_matrix_c::finish() {
+	free();
+	rows = building.size();
+	row_offset = new int[rows + 1];
+	row_column = new int[rows];
+
+	//Find the columns of each row and pad them
+	row_offset[0] = 0;
+	for(int i = 0; i < rows; i++) {
+		int first = columns, last = 0;
+		for(size_t j = 0; j < building[i].size(); j++) {
+			first = std::min(first, building[i][j].first);
+			last = std::max(last, building[i][j].first + 1);
+		}
+		if(first >= last) first = last = 0;
+		const int length = (last - first + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+		//Move the padded row left if it would go past the last column
+		row_column[i] = std::max(std::min(first, columns - length), 0);
+		row_offset[i + 1] = row_offset[i] + length;
+	}
+
+	weights = simd_new_floats(std::max(row_offset[rows], SIMD_WIDTH));
+	for(int i = 0; i < rows; i++) {
+		for(size_t j = 0; j < building[i].size(); j++) {
+			weights[row_offset[i] + building[i][j].first - row_column[i]]+= building[i][j].second;
+		}
+	}
+	building.clear();
+}
+
+//Multiplies both the left and the right spectrum with the matrix in a single sweep
+void rebin_matrix_c::apply(const float *inputL, const float *inputR, float *outputL, float *outputR) const {
+	for(int i = 0; i < rows; i++) {
+		const float *w = weights + row_offset[i];
+		const float *l = inputL + row_column[i];
+		const float *r = inputR + row_column[i];
+		const int length = row_offset[i + 1] - row_offset[i];
+		simd_float sumL = simd_set1(0.0f);
+		simd_float sumR = simd_set1(0.0f);
+		for(int j = 0; j < length; j+= SIMD_WIDTH) {
+			const simd_float weight = simd_load(w + j);
+			sumL = simd_add(sumL, simd_mul(weight, simd_loadu(l + j)));
+			sumR = simd_add(sumR, simd_mul(weight, simd_loadu(r + j)));
+		}
+		outputL[i] = simd_sum(sumL);
+		outputR[i] = simd_sum(sumR);
+	}
+}
+
+//The original bars where every bar is bar_mult times wider than the previous one
+//The full columns are taken one index lower than the partial ones just like the visualizer always did
+//Returns the amount of bars
+int generate_log_bars(rebin_matrix_c &matrix, const double bar_mult, const int spectrum_start, const int spectrum_end) {
+	int bar_amount = 0;
+	float i = bar_mult - 1;
+	float start = 0;
+	while(start + i <= spectrum_end) {
+		if(start >= spectrum_start) {
+			const float end = start + i;
+			const int full_start = ceil(start);
+			const int first = floor(start);
+			const int last = floor(end);
+			float first_mult = full_start == first ? 0.0 : 1.0 - start + floor(start);
+			float last_mult = end - floor(end);
+			if(first == last) {
+				first_mult = end - start;
+				last_mult = 0.0;
+			}
+
+			matrix.begin_row();
+			matrix.add_weight(first, first_mult);
+			matrix.add_weight(last, last_mult);
+			for(int j = full_start; j < last; j++) matrix.add_weight(j - 1, 1.0f);
+			bar_amount++;
+		}
+		start+= i;
+		i*= bar_mult;
+	}
+	matrix.finish();
+	return bar_amount;
+}
+
+//Conversions between Hz and the different scales
+double to_scale(const frequency_scale scale, const double hz) {
+	switch(scale) {
+		case SCALE_MEL: return 2595.0 * log10(1.0 + hz / 700.0);
+		case SCALE_BARK: return 26.81 * hz / (1960.0 + hz) - 0.53;
+		case SCALE_ERB: return 21.4 * log10(1.0 + 0.00437 * hz);
+		default: return log(hz);
+	}
+}
+double from_scale(const frequency_scale scale, const double value) {
+	switch(scale) {
+		case SCALE_MEL: return 700.0 * (pow(10.0, value / 2595.0) - 1.0);
+		case SCALE_BARK: return 1960.0 * (value + 0.53) / (26.28 - value);
+		case SCALE_ERB: return (pow(10.0, value / 21.4) - 1.0) / 0.00437;
+		default: return exp(value);
+	}
+}
+
+//Bars that are evenly spread on the given scale
+//Returns the amount of bars
+int generate_scale_bars(rebin_matrix_c &matrix, const frequency_scale scale, const int bar_amount, const int spectrum_start, const int spectrum_end, const float bin_size) {
+	const double low = to_scale(scale, spectrum_start * bin_size);
+	const double high = to_scale(scale, spectrum_end * bin_size);
+	for(int i = 0; i < bar_amount; i++) {
+		const float start = from_scale(scale, low + (high - low) * i / bar_amount) / bin_size;
+		const float end = from_scale(scale, low + (high - low) * (i + 1) / bar_amount) / bin_size;
+		matrix.begin_row();
+		matrix.add_range(start, end);
+	}
+	matrix.finish();
+	return bar_amount;
+}
@@ -0,0 +1,63 @@
+/** rebin.hpp **/
+
+#ifndef REBIN_HPP
+#define REBIN_HPP
+
+#include <vector>
+#include <utility>
+
+//The frequency scales that the bars can be spread on
+enum frequency_scale {
+	SCALE_LOG, //Every bar is BAR_MULT times wider than the previous one
+	SCALE_MEL,
+	SCALE_BARK,
+	SCALE_ERB
+};
+
+/*
+	A sparse matrix that turns the linear spectrum into bars
+	Every bar (row) is a weighted sum of the spectrum values (columns) it covers
+	The matrix is stored in compressed sparse row format where the columns of each row are contiguous:
+	  a row has its first column and an offset to its weights
+	Each row is padded with zeros to a multiple of SIMD_WIDTH and the weights are aligned
+	  so the multiplication is done with aligned vector loads and no branches
+*/
+class rebin_matrix_c {
+	private:
+		rebin_matrix_c(const rebin_matrix_c &obj); //Copy constructor
+		rebin_matrix_c &operator=(const rebin_matrix_c &obj); //Assign operator
+
+		const int columns;
+		int rows;
+		int *row_offset; //rows + 1 offsets to the weights
+		int *row_column; //The first column of each row
+		float *weights;
+
+		//Used while the matrix is being built
+		std::vector<std::vector<std::pair<int, float> > > building;
+
+		void free();
+
+	public:
+		rebin_matrix_c(const int columns);
+		~rebin_matrix_c();
+
+		//Building the matrix
+		void begin_row();
+		void add_weight(const int column, const float weight);
+		void add_range(const float start, const float end);
+		void finish();
+
+		void apply(const float *inputL, const float *inputR, float *outputL, float *outputR) const;
+		int get_rows() const { return rows; }
+		const int *get_row_offsets() const { return row_offset; }
+		const int *get_row_columns() const { return row_column; }
+		const float *get_weights() const { return weights; }
+};
+
+//Matrix generators for the different frequency scales
+//start and end are the spectrum indices of the shown range and bin_size is the width of one index in Hz
+int generate_log_bars(rebin_matrix_c &matrix, const double bar_mult, const int start, const int end);
+int generate_scale_bars(rebin_matrix_c &matrix, const frequency_scale scale, const int bar_amount, const int start, const int end, const float bin_size);
+
+#endif
@@ -0,0 +1,32 @@
+/** render_queue.cpp **/
+
+#include <iostream>
+#include <algorithm>
+#include "render_queue.hpp"
+
+inline bool command_less(const render_command &a, const render_command &b) {
+	return a.key < b.key;
+}
+
+//The object names are only used for grouping so they are cut to their lowest bits
+//The order of adding is the last part of the key so the sorting is stable
+void render_queue_c::add(const render_command &command) {
+	if(amount == MAX_RENDER_COMMANDS) {
+		std::cerr << "Too many render commands in a frame!" << std::endl;
+		return;
+	}
+	render_command &added = commands[amount];
+	added = command;
+	added.key = (uint64_t)(command.pass & 0x3) << 62
+		| (uint64_t)(command.layer & 0xFF) << 54
+		| (uint64_t)(command.program & 0xFFF) << 42
+		| (uint64_t)(command.blend & 0x3) << 40
+		| (uint64_t)(command.vertex_array & 0xFFF) << 28
+		| (uint64_t)(command.buffer & 0xFFF) << 16
+		| (uint64_t)amount;
+	amount++;
+}
+
+void render_queue_c::sort() {
+	std::sort(commands, commands + amount, command_less);
+}
@@ -0,0 +1,74 @@
+/** render_queue.hpp **/
+
+#ifndef RENDER_QUEUE_HPP
+#define RENDER_QUEUE_HPP
+
+#include <cstddef>
+#include <stdint.h>
+#include <GL/glew.h>
+#include "gl_state.hpp"
+
+//The most commands in one frame
+#define MAX_RENDER_COMMANDS 64
+
+//A batch of rectangles or squares written to the stream buffer of graphics_c
+struct draw_batch {
+	size_t offset;
+	int amount;
+};
+
+//The targets of the commands in the order they are drawn
+enum render_pass {
+	PASS_FEEDBACK, //The feedback texture of graphics_c
+	PASS_PRESENT //The screen
+};
+
+enum command_type {
+	COMMAND_RECTS,
+	COMMAND_SQUARES,
+	COMMAND_GENERATED, //Instances without vertex attributes, for example the bars of gpu_bars_c
+	COMMAND_PRESENT
+};
+
+/*
+	One recorded draw call of graphics_c
+	The pass and the layer decide the order of the drawn things, the commands of the same layer may be drawn in any order
+	  so that the commands with the same state are next to each other
+*/
+struct render_command {
+	uint64_t key; //Set by render_queue_c
+	command_type type;
+	render_pass pass;
+	int layer;
+	GLuint program;
+	GLuint vertex_array;
+	GLuint buffer;
+	blend_mode blend;
+	draw_batch batch; //The amount is the amount of instances
+	const char *name; //The name of the pass in the GPU profiler, a literal
+};
+
+/*
+	The commands of a frame are recorded here and graphics_c submits them sorted by their key
+	The key has the pass and the layer first and then the program, the blending, the vertex array and the buffer
+	  so the sorting never changes the order of different layers but groups the same state within a layer
+	The commands are kept in a fixed array so recording a frame doesn't allocate anything
+*/
+class render_queue_c {
+	private:
+		render_queue_c(const render_queue_c &obj); //Copy constructor
+		render_queue_c &operator=(const render_queue_c &obj); //Assign operator
+
+		render_command commands[MAX_RENDER_COMMANDS];
+		int amount;
+
+	public:
+		render_queue_c(): amount(0) {}
+		void add(const render_command &command);
+		void sort();
+		void clear() { amount = 0; }
+		int get_amount() const { return amount; }
+		const render_command &operator[](const int index) const { return commands[index]; }
+};
+
+#endif
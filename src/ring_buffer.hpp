@@ -0,0 +1,80 @@
+/** ring_buffer.hpp **/
+
+#ifndef RING_BUFFER_HPP
+#define RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+/*
+	Wait-free ring buffer for one producer thread and one consumer thread
+	Neither side ever blocks: the producer writes only what fits and the consumer reads only what is available
+	The positions keep increasing and wrap around naturally, the capacity is rounded up to a power of two
+*/
+template<class T> class ring_buffer_c {
+	private:
+		ring_buffer_c(const ring_buffer_c &obj); //Copy constructor
+		ring_buffer_c &operator=(const ring_buffer_c &obj); //Assign operator
+
+		static unsigned int round_capacity(const unsigned int capacity) {
+			unsigned int c = 1;
+			while(c < capacity) c*= 2;
+			return c;
+		}
+
+		const unsigned int capacity;
+		T *const buffer;
+		//The positions are on their own cache lines so that the two threads don't fight over them
+		alignas(64) std::atomic<unsigned int> write_pos;
+		alignas(64) std::atomic<unsigned int> read_pos;
+
+		//Copies between the buffer and a linear array taking the wrap around into account
+		void copy_in(const unsigned int pos, const T *data, const unsigned int amount) {
+			const unsigned int start = pos & (capacity - 1);
+			const unsigned int first = std::min(amount, capacity - start);
+			memcpy(buffer + start, data, sizeof(T) * first);
+			memcpy(buffer, data + first, sizeof(T) * (amount - first));
+		}
+		void copy_out(const unsigned int pos, T *data, const unsigned int amount) const {
+			const unsigned int start = pos & (capacity - 1);
+			const unsigned int first = std::min(amount, capacity - start);
+			memcpy(data, buffer + start, sizeof(T) * first);
+			memcpy(data + first, buffer, sizeof(T) * (amount - first));
+		}
+
+	public:
+		ring_buffer_c(const unsigned int min_capacity):
+			capacity(round_capacity(min_capacity)), buffer(new T[capacity]), write_pos(0), read_pos(0) {}
+		~ring_buffer_c() { delete [] buffer; }
+
+		//Producer side
+		//Returns the amount of elements that were written
+		unsigned int write(const T *data, const unsigned int amount) {
+			const unsigned int w = write_pos.load(std::memory_order_relaxed);
+			const unsigned int space = capacity - (w - read_pos.load(std::memory_order_acquire));
+			const unsigned int n = std::min(amount, space);
+			copy_in(w, data, n);
+			write_pos.store(w + n, std::memory_order_release);
+			return n;
+		}
+
+		//Consumer side
+		//Returns the amount of elements that were read
+		unsigned int read(T *data, const unsigned int amount) {
+			const unsigned int r = read_pos.load(std::memory_order_relaxed);
+			const unsigned int n = std::min(amount, write_pos.load(std::memory_order_acquire) - r);
+			copy_out(r, data, n);
+			read_pos.store(r + n, std::memory_order_release);
+			return n;
+		}
+
+		//Consumer side
+		unsigned int available() const {
+			return write_pos.load(std::memory_order_acquire) - read_pos.load(std::memory_order_relaxed);
+		}
+
+		unsigned int get_capacity() const { return capacity; }
+};
+
+#endif
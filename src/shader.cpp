@@ -4,6 +4,7 @@
 #include <iostream>
 #include <fstream>
 #include <cstring>
+#include "trace.hpp"
 
 enum {
 	PROGRAM, SHADER
@@ -32,6 +33,7 @@ void print_shader_log(const GLuint obj, const unsigned char type) {
 
 //This function loads a shader from a file and turns it into an OpenGL shader
 GLuint load_shader(const char *path, const GLenum type) {
+	scoped_trace_c trace("load_shader");
 	//Load from file
 	std::ifstream file(path, std::ios::in | std::ios::binary | std::ios::ate);
 	const unsigned int size = file.tellg();
@@ -61,8 +63,10 @@ GLuint load_shader(const char *path, const GLenum type) {
 }
 
 //Initializes the shader from the given vertex and fragment shader file paths
-shader::shader(const char *vprog, const char *fprog): program(glCreateProgram()) {
+//fprog2 is an optional second fragment shader that is linked to the same program
+shader::shader(const char *vprog, const char *fprog, const char *fprog2): program(glCreateProgram()) {
 	add_fragment_shader(fprog);
+	if(fprog2) add_fragment_shader(fprog2);
 	add_vertex_shader(vprog);
 }
 
@@ -84,6 +88,7 @@ void shader::add_vertex_shader(const char *vprog) {
 	glAttachShader(program, vertex_shaders.back());
 
 	if(!vertex_shaders.empty() && !fragment_shaders.empty()) {
+		scoped_trace_c trace("link_program");
 		glLinkProgram(program);
 		glUseProgram(program);
 		print_shader_log(program, PROGRAM);
@@ -96,12 +101,17 @@ void shader::add_fragment_shader(const char *fprog) {
 	glAttachShader(program, fragment_shaders.back());
 
 	if(!vertex_shaders.empty() && !fragment_shaders.empty()) {
+		scoped_trace_c trace("link_program");
 		glLinkProgram(program);
 		glUseProgram(program);
 		print_shader_log(program, PROGRAM);
 	}
 }
 
+GLint shader::get_uniform_location(const char *name) const {
+	return glGetUniformLocation(program, name);
+}
+
 //Enable the shader
 void shader::use() const {
 	glUseProgram(program);
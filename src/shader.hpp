@@ -3,6 +3,7 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
+#include <cstddef>
 #include <vector>
 #include <GL/glew.h>
 
@@ -21,10 +22,12 @@ class shader {
 		std::vector<GLuint> fragment_shaders;
 
 	public:
-		shader(const char *vprog, const char *fprog);
+		shader(const char *vprog, const char *fprog, const char *fprog2 = NULL);
 		~shader();
 		void add_vertex_shader(const char *vprog);
 		void add_fragment_shader(const char *fprog);
+		GLint get_uniform_location(const char *name) const;
+		GLuint get_program() const { return program; }
 		void use() const;
 		void operator()() const;
 };
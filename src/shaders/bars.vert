@@ -0,0 +1,69 @@
+#version 140 //GLSL version 1.4 (OpenGL 3.1)
+
+//Calculates the heights of the bars from the spectrum, see gpu_bars.cpp
+//Every bar is an instance of 4 vertices and there are no vertex attributes
+
+uniform samplerBuffer spectrum; //The left and the right spectrum summed
+uniform samplerBuffer positions; //The x coordinates of the bars, one more than there are bars
+
+//The rebin matrix of the bars with constant width
+uniform isamplerBuffer row_offsets; //One more than there are bars
+uniform isamplerBuffer row_columns;
+uniform samplerBuffer weights;
+
+uniform int bar_type;
+uniform bool smooth_bars;
+uniform int bar_amount;
+uniform int spectrum_start;
+
+//Brightness and alpha at the bottom and at the top of the bars
+uniform vec4 color;
+
+out vec2 f_color;
+
+float spectrum_value(int i) {
+	return texelFetch(spectrum, i).r;
+}
+
+//The same as constant_width_bars in analyzer.cpp
+float constant_width_height(int bar) {
+	bar = clamp(bar, 0, bar_amount - 1);
+	int start = texelFetch(row_offsets, bar).r;
+	int end = texelFetch(row_offsets, bar + 1).r;
+	int column = texelFetch(row_columns, bar).r - start;
+	float sum = 0.0;
+	for(int i = start; i < end; i++) sum+= texelFetch(weights, i).r * spectrum_value(column + i);
+	return max(sum * 5.0 - 0.04, 0.0) + 0.015;
+}
+
+//The same as variable_width_bars in analyzer.cpp
+float variable_width_height(int bar) {
+	int i = spectrum_start + bar;
+	float value;
+	if(smooth_bars) {
+		value = 0.038 * (spectrum_value(i - 2) + spectrum_value(i + 2))
+			+ 0.154 * (spectrum_value(i - 1) + spectrum_value(i + 1))
+			+ 0.615 * spectrum_value(i);
+	}
+	else value = spectrum_value(i);
+	float size = texelFetch(positions, bar + 1).r - texelFetch(positions, bar).r;
+	return max(value / size * 0.05 - 0.04, 0.0) + 0.015;
+}
+
+void main() {
+	int bar = gl_InstanceID;
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1); //From (0, 0) to (1, 1)
+
+	float height;
+	if(bar_type == 2) height = variable_width_height(bar);
+	else if(smooth_bars) {
+		height = 0.038 * (constant_width_height(bar - 2) + constant_width_height(bar + 2))
+			+ 0.154 * (constant_width_height(bar - 1) + constant_width_height(bar + 1))
+			+ 0.615 * constant_width_height(bar);
+	}
+	else height = constant_width_height(bar);
+
+	float x = texelFetch(positions, bar + int(corner.x)).r;
+	f_color = mix(color.xy, color.zw, corner.y);
+	gl_Position = vec4(x, -1.0 + height * corner.y, 0.0, 1.0);
+}
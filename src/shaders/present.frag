@@ -0,0 +1,23 @@
+#version 140 //GLSL version 1.4 (OpenGL 3.1)
+
+//GLSL version 3.3 (OpenGL 3.3) feature
+//Required for layout(location = 0)
+#extension GL_ARB_explicit_attrib_location : require
+
+//Shows the frame and fades it for the next frame in the same pass
+//The effect is linked from another file (for example normal.frag) and only affects what is shown
+
+in vec2 f_tex_coord;
+
+layout(location = 0) out vec4 color; //The screen
+layout(location = 1) out vec4 feedback; //The start of the next frame
+
+uniform sampler2D texture1; //Initialized to 0 by default (no need to set using glUniform)
+uniform float decay; //How much of the frame is left on the next frame
+
+vec4 effect(vec2 tex_coord);
+
+void main() {
+	color = effect(f_tex_coord);
+	feedback = vec4(texture2D(texture1, f_tex_coord).rgb * decay, 1.0);
+}
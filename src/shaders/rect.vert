@@ -0,0 +1,23 @@
+#version 140 //GLSL version 1.4 (OpenGL 3.1)
+
+//GLSL version 3.3 (OpenGL 3.3) feature
+//Required for layout(location = 0)
+#extension GL_ARB_explicit_attrib_location : require
+
+//Must be the same as RECT_RANGE in graphics.hpp
+#define RECT_RANGE 4.0
+
+layout(location = 0) in vec2 corner; //From (0, 0) to (1, 1)
+layout(location = 1) in vec4 rect; //x1, y1, x2, y2 divided by RECT_RANGE, one per instance
+layout(location = 2) in uint color_index; //One per instance
+
+//Brightness and alpha at the bottom and at the top of the rectangle
+uniform vec4 palette[8];
+
+out vec2 f_color;
+
+void main() {
+	vec4 colors = palette[color_index];
+	f_color = mix(colors.xy, colors.zw, corner.y);
+	gl_Position = vec4(mix(rect.xy, rect.zw, corner) * RECT_RANGE, 0.0, 1.0);
+}
@@ -1,16 +1,14 @@
 #version 140 //GLSL version 1.4 (OpenGL 3.1)
 
-in vec2 f_tex_coord;
-
-out vec4 color;
+//The effects are applied when the frame is shown, see present.frag
 
 uniform sampler2D texture1; //Initialized to 0 by default (no need to set using glUniform)
 
-void main() {
+vec4 effect(vec2 tex_coord) {
 	//move red and blue channels horizontally
-	color = vec4(
-		texture2D(texture1, f_tex_coord + vec2(-0.01, 0.0)).r,
-		texture2D(texture1, f_tex_coord + vec2( 0.0,  0.0)).g,
-		texture2D(texture1, f_tex_coord + vec2( 0.01, 0.0)).b,
+	return vec4(
+		texture2D(texture1, tex_coord + vec2(-0.01, 0.0)).r,
+		texture2D(texture1, tex_coord + vec2( 0.0,  0.0)).g,
+		texture2D(texture1, tex_coord + vec2( 0.01, 0.0)).b,
 		1.0);
 }
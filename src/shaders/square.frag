@@ -0,0 +1,29 @@
+#version 140 //GLSL version 1.4 (OpenGL 3.1)
+
+//Motion blur of a square in closed form
+//The size of the square goes linearly from f_sizes.x to f_sizes.y during the motion
+//A point is inside the square when the size is at least its distance from the center
+//  so the brightness is the fraction of the motion during which the size is large enough
+//This equals drawing the square an infinite amount of times with additive blending
+
+in vec2 f_position;
+flat in vec2 f_sizes;
+flat in vec2 f_color;
+
+out vec4 color;
+
+//The fraction of t from 0 to 1 where start + (end - start) * t >= limit
+float fraction_above(float start, float end, float limit) {
+	float change = end - start;
+	if(abs(change) < 1e-6) return start >= limit ? 1.0 : 0.0;
+	float t = (limit - start) / change;
+	return change > 0.0 ? clamp(1.0 - t, 0.0, 1.0) : clamp(t, 0.0, 1.0);
+}
+
+void main() {
+	float distance = max(abs(f_position.x), abs(f_position.y));
+	//Negative sizes cover the same area as positive ones
+	float coverage = fraction_above(f_sizes.x, f_sizes.y, distance) + fraction_above(-f_sizes.x, -f_sizes.y, distance);
+	if(coverage <= 0.0) discard;
+	color = vec4(vec3(f_color.x * coverage), f_color.y);
+}
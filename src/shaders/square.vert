@@ -0,0 +1,30 @@
+#version 140 //GLSL version 1.4 (OpenGL 3.1)
+
+//GLSL version 3.3 (OpenGL 3.3) feature
+//Required for layout(location = 0)
+#extension GL_ARB_explicit_attrib_location : require
+
+//A square that moves from one size to another during the frame, see square.frag
+//The size is half of the height and the width is width_ratio times the height
+
+layout(location = 0) in vec2 corner; //From (0, 0) to (1, 1)
+layout(location = 1) in vec3 square; //x, y and width_ratio, one per instance
+layout(location = 2) in vec2 sizes; //The size at the start and at the end of the motion, one per instance
+layout(location = 3) in uint color_index; //One per instance
+
+//Brightness and alpha of the fully covered parts
+//Only the bottom color of the palette is used
+uniform vec4 palette[8];
+
+out vec2 f_position; //Relative to the center of the square, x is divided by width_ratio
+flat out vec2 f_sizes;
+flat out vec2 f_color;
+
+void main() {
+	//The quad covers the square at its largest
+	float extent = max(abs(sizes.x), abs(sizes.y));
+	f_position = (corner * 2.0 - 1.0) * extent;
+	f_sizes = sizes;
+	f_color = palette[color_index].xy;
+	gl_Position = vec4(square.xy + f_position * vec2(square.z, 1.0), 0.0, 1.0);
+}
@@ -0,0 +1,104 @@
+/** simd.hpp **/
+
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+#include <cstdlib>
+#ifdef _WIN32
+	#include <malloc.h>
+#endif
+
+/*
+	Small wrapper for the SIMD instruction sets used by the analysis code
+	AVX is used when the compiler targets it (for example with -mavx or -march=native)
+	  otherwise SSE is used, which all x86-64 compilers target by default
+	Other architectures fall back to plain scalar code with SIMD_WIDTH 1
+*/
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define SIMD_WIDTH 8
+	typedef __m256 simd_float;
+	inline simd_float simd_load(const float *p) { return _mm256_load_ps(p); }
+	inline simd_float simd_loadu(const float *p) { return _mm256_loadu_ps(p); }
+	inline void simd_store(float *p, const simd_float a) { _mm256_store_ps(p, a); }
+	inline void simd_storeu(float *p, const simd_float a) { _mm256_storeu_ps(p, a); }
+	inline simd_float simd_set1(const float a) { return _mm256_set1_ps(a); }
+	inline simd_float simd_add(const simd_float a, const simd_float b) { return _mm256_add_ps(a, b); }
+	inline simd_float simd_sub(const simd_float a, const simd_float b) { return _mm256_sub_ps(a, b); }
+	inline simd_float simd_mul(const simd_float a, const simd_float b) { return _mm256_mul_ps(a, b); }
+	inline simd_float simd_sqrt(const simd_float a) { return _mm256_sqrt_ps(a); }
+	//Reverses the order of the elements
+	inline simd_float simd_reverse(const simd_float a) {
+		const __m256 b = _mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3));
+		return _mm256_permute2f128_ps(b, b, 1);
+	}
+	inline float simd_sum(const simd_float a) {
+		const __m128 b = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+		const __m128 c = _mm_add_ps(b, _mm_movehl_ps(b, b));
+		return _mm_cvtss_f32(_mm_add_ss(c, _mm_shuffle_ps(c, c, 1)));
+	}
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#include <xmmintrin.h>
+	#define SIMD_WIDTH 4
+	typedef __m128 simd_float;
+	inline simd_float simd_load(const float *p) { return _mm_load_ps(p); }
+	inline simd_float simd_loadu(const float *p) { return _mm_loadu_ps(p); }
+	inline void simd_store(float *p, const simd_float a) { _mm_store_ps(p, a); }
+	inline void simd_storeu(float *p, const simd_float a) { _mm_storeu_ps(p, a); }
+	inline simd_float simd_set1(const float a) { return _mm_set1_ps(a); }
+	inline simd_float simd_add(const simd_float a, const simd_float b) { return _mm_add_ps(a, b); }
+	inline simd_float simd_sub(const simd_float a, const simd_float b) { return _mm_sub_ps(a, b); }
+	inline simd_float simd_mul(const simd_float a, const simd_float b) { return _mm_mul_ps(a, b); }
+	inline simd_float simd_sqrt(const simd_float a) { return _mm_sqrt_ps(a); }
+	//Reverses the order of the elements
+	inline simd_float simd_reverse(const simd_float a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 1, 2, 3)); }
+	inline float simd_sum(const simd_float a) {
+		const __m128 b = _mm_add_ps(a, _mm_movehl_ps(a, a));
+		return _mm_cvtss_f32(_mm_add_ss(b, _mm_shuffle_ps(b, b, 1)));
+	}
+#else
+	#include <cmath>
+	#define SIMD_WIDTH 1
+	typedef float simd_float;
+	inline simd_float simd_load(const float *p) { return *p; }
+	inline simd_float simd_loadu(const float *p) { return *p; }
+	inline void simd_store(float *p, const simd_float a) { *p = a; }
+	inline void simd_storeu(float *p, const simd_float a) { *p = a; }
+	inline simd_float simd_set1(const float a) { return a; }
+	inline simd_float simd_add(const simd_float a, const simd_float b) { return a + b; }
+	inline simd_float simd_sub(const simd_float a, const simd_float b) { return a - b; }
+	inline simd_float simd_mul(const simd_float a, const simd_float b) { return a * b; }
+	inline simd_float simd_sqrt(const simd_float a) { return std::sqrt(a); }
+	inline simd_float simd_reverse(const simd_float a) { return a; }
+	inline float simd_sum(const simd_float a) { return a; }
+#endif
+
+//All the buffers used with simd_load and simd_store must be aligned to this
+#define SIMD_ALIGNMENT 32
+
+//Allocates memory aligned to SIMD_ALIGNMENT
+inline void *simd_malloc(const size_t size) {
+	#ifdef _WIN32
+		return _aligned_malloc(size, SIMD_ALIGNMENT);
+	#else
+		void *p;
+		return posix_memalign(&p, SIMD_ALIGNMENT, size) == 0 ? p : NULL;
+	#endif
+}
+
+inline void simd_free(void *p) {
+	#ifdef _WIN32
+		_aligned_free(p);
+	#else
+		free(p);
+	#endif
+}
+
+//Allocates an aligned float array that is initialized to zero
+inline float *simd_new_floats(const size_t amount) {
+	float *p = (float*)simd_malloc(sizeof(float) * amount);
+	for(size_t i = 0; i < amount; i++) p[i] = 0.0f;
+	return p;
+}
+
+#endif
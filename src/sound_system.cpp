@@ -1,7 +1,12 @@
 /** sound_system.cpp **/
 
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
 #include "sound_system.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
 
 /// NOTE: if compiling FMOD gives you an error, look at sound_system.hpp
 //FMOD include
@@ -13,38 +18,170 @@
 	#undef _stdcall
 #endif
 
+//The amount of failed FMOD calls for the metrics
+static std::atomic<unsigned int> fmod_errors(0);
+
 //Function for handling FMOD errors
 inline void fmod_errorcheck(const FMOD_RESULT result) {
 	if(result != FMOD_OK) {
+		fmod_errors.fetch_add(1, std::memory_order_relaxed);
 		std::cout << "FMOD error! (" << result << ") " << FMOD_ErrorString(result) << std::endl;
 	}
 }
 
-sound_system_c::sound_system_c(const char *song_name) {
-	// Init FMOD
+//Creates the FMOD system before the members that need it are initialized
+//wav_name is the file written with OUTPUT_WAVWRITER_NRT
+FMOD_SYSTEM *init_fmod(const sound_output output, const char *wav_name) {
+	FMOD_SYSTEM *fmod_system;
 	fmod_errorcheck(FMOD_System_Create(&fmod_system));
+	if(output == OUTPUT_NOSOUND) fmod_errorcheck(FMOD_System_SetOutput(fmod_system, FMOD_OUTPUTTYPE_NOSOUND));
+	if(output == OUTPUT_NRT) fmod_errorcheck(FMOD_System_SetOutput(fmod_system, FMOD_OUTPUTTYPE_NOSOUND_NRT));
+	if(output == OUTPUT_WAVWRITER_NRT) fmod_errorcheck(FMOD_System_SetOutput(fmod_system, FMOD_OUTPUTTYPE_WAVWRITER_NRT));
 	fmod_errorcheck(FMOD_System_SetSoftwareFormat(fmod_system, OUTPUTRATE, FMOD_SOUND_FORMAT_PCM16, 2, 0, FMOD_DSP_RESAMPLER_LINEAR));
-	fmod_errorcheck(FMOD_System_Init(fmod_system, 32, FMOD_INIT_NORMAL, 0));
+	fmod_errorcheck(FMOD_System_Init(fmod_system, 32, FMOD_INIT_NORMAL, output == OUTPUT_WAVWRITER_NRT ? (void*)wav_name : 0));
+	return fmod_system;
+}
+
+sound_system_c::sound_system_c(const char *song_name, const sound_output output, const char *wav_name):
+	fmod_system(init_fmod(output, wav_name)),
+	tap(fmod_system, TAP_CAPACITY),
+	tap_samples(new stereo_sample[SPECTRUMSIZE * 2]),
+	fft(SPECTRUMSIZE),
+	waveL(simd_new_floats(SPECTRUMSIZE * 2)),
+	waveR(simd_new_floats(SPECTRUMSIZE * 2)) {
+
 	// Init song
-	fmod_errorcheck(FMOD_System_CreateStream(fmod_system, song_name, FMOD_LOOP_NORMAL | FMOD_2D | FMOD_HARDWARE | FMOD_UNIQUE, 0, &music));
+	fmod_errorcheck(FMOD_System_CreateStream(fmod_system, song_name, (output == OUTPUT_NRT || output == OUTPUT_WAVWRITER_NRT ? FMOD_LOOP_OFF : FMOD_LOOP_NORMAL) | FMOD_2D | FMOD_HARDWARE | FMOD_UNIQUE, 0, &music));
+
+	//The mixed blocks wait in the output buffers before they are heard, without realtime output nothing is heard
+	unsigned int buffer_length = 0;
+	int buffers = 0;
+	fmod_errorcheck(FMOD_System_GetDSPBufferSize(fmod_system, &buffer_length, &buffers));
+	output_latency = output == OUTPUT_NRT || output == OUTPUT_WAVWRITER_NRT ? 0.0 : (double)buffer_length * buffers / OUTPUTRATE;
+
+	//The song is resampled to OUTPUTRATE but its positions are in its own samples
+	sound_rate = OUTPUTRATE;
+	length_pcm = 0;
+	fmod_errorcheck(FMOD_Sound_GetDefaults(music, &sound_rate, NULL, NULL, NULL));
+	fmod_errorcheck(FMOD_Sound_GetLength(music, &length_pcm, FMOD_TIMEUNIT_PCM));
+	if(sound_rate <= 0.0f) sound_rate = OUTPUTRATE;
 }
 
 sound_system_c::~sound_system_c() {
+	if(tap.get_dropped() > 0) std::cout << "Analysis didn't keep up, " << tap.get_dropped() << " samples were dropped" << std::endl;
 	fmod_errorcheck(FMOD_Sound_Release(music));
+	tap.release();
 	fmod_errorcheck(FMOD_System_Close(fmod_system));
 	fmod_errorcheck(FMOD_System_Release(fmod_system));
+	delete [] tap_samples;
+	simd_free(waveL);
+	simd_free(waveR);
 }
 
+//Starts the music paused so that the DSP tap is in place before the first samples are mixed
 void sound_system_c::play_music() {
-	fmod_errorcheck(FMOD_System_PlaySound(fmod_system, FMOD_CHANNEL_FREE, music, false, &channel));
+	scoped_trace_c trace("play_music");
+	fmod_errorcheck(FMOD_System_PlaySound(fmod_system, FMOD_CHANNEL_FREE, music, true, &channel));
+	tap.attach(channel);
+	fmod_errorcheck(FMOD_Channel_SetPaused(channel, false));
+}
+
+//Moves the new samples from the DSP tap to the end of the analysis window
+//This way every mixed sample goes through the analysis window exactly once
+//At most the given amount of samples is moved, 0 moves all of them
+void sound_system_c::advance(const unsigned int max_samples) {
+	scoped_trace_c trace("advance");
+	unsigned int samples = max_samples;
+	const unsigned int window = SPECTRUMSIZE * 2;
+	if(samples == 0) samples = tap.available();
+	unsigned int amount;
+	while(samples > 0 && (amount = tap.read(tap_samples, std::min(samples, window))) > 0) {
+		samples-= amount;
+		const unsigned int keep = window - amount;
+		memmove(waveL, waveL + amount, sizeof(float) * keep);
+		memmove(waveR, waveR + amount, sizeof(float) * keep);
+		for(unsigned int i = 0; i < amount; i++) {
+			waveL[keep + i] = tap_samples[i].left;
+			waveR[keep + i] = tap_samples[i].right;
+		}
+	}
+}
+
+//This analyzes the spectrum of the music
+//The analysis window of both channels is analyzed with a single FFT
+//advance should be called first to get the latest samples to the window
+void sound_system_c::get_spectrum(float *spectrumL, float *spectrumR) {
+	scoped_trace_c trace("get_spectrum");
+	#ifdef FMOD_SPECTRUM
+		fmod_errorcheck(FMOD_Channel_GetSpectrum(channel, spectrumL, SPECTRUMSIZE, 0, FMOD_DSP_FFT_WINDOW_TRIANGLE));
+		fmod_errorcheck(FMOD_Channel_GetSpectrum(channel, spectrumR, SPECTRUMSIZE, 1, FMOD_DSP_FFT_WINDOW_TRIANGLE));
+	#else
+		fft.analyze(waveL, waveR, spectrumL, spectrumR);
+	#endif
+}
+
+//The amount of mixed samples that are not yet taken to the analysis
+unsigned int sound_system_c::get_available_samples() const {
+	return tap.available();
+}
+
+//The position in the song of the newest sample in the analysis window
+//The channel position tells how far FMOD has mixed so the samples still waiting in the tap are subtracted
+unsigned int sound_system_c::get_position_ms() const {
+	scoped_trace_c trace("get_position_ms");
+	const unsigned int waiting_ms = (unsigned long long)tap.available() * 1000 / OUTPUTRATE;
+	unsigned int position = 0;
+	fmod_errorcheck(FMOD_Channel_GetPosition(channel, &position, FMOD_TIMEUNIT_MS));
+	const unsigned int length = get_length_ms();
+	if(length == 0) return 0;
+	return (position + length - waiting_ms % length) % length;
+}
+
+//The position in the song in PCM samples of the middle of the analysis window, which is what the spectrum mostly shows
+//The samples in the tap and the window are mixed at OUTPUTRATE so they are converted to the samples of the song
+unsigned int sound_system_c::get_window_position() const {
+	scoped_trace_c trace("get_window_position");
+	unsigned int position = 0;
+	fmod_errorcheck(FMOD_Channel_GetPosition(channel, &position, FMOD_TIMEUNIT_PCM));
+	if(length_pcm == 0) return 0;
+	const unsigned int behind = (tap.available() + SPECTRUMSIZE) * (double)sound_rate / OUTPUTRATE;
+	return (position + length_pcm - behind % length_pcm) % length_pcm;
+}
+
+//Seconds from now until the middle of the analysis window is heard, negative if it has been heard already
+double sound_system_c::get_window_delay() const {
+	return output_latency - (double)(tap.available() + SPECTRUMSIZE) / OUTPUTRATE;
+}
+
+unsigned int sound_system_c::get_length_ms() const {
+	unsigned int length = 0;
+	fmod_errorcheck(FMOD_Sound_GetLength(music, &length, FMOD_TIMEUNIT_MS));
+	return length;
+}
+
+//Tells whether the music is still playing, it stops only with the NRT outputs
+//The channel handle becomes invalid once the music has ended so errors are expected here
+bool sound_system_c::is_playing() const {
+	FMOD_BOOL playing = false;
+	return FMOD_Channel_IsPlaying(channel, &playing) == FMOD_OK && playing;
+}
+
+void sound_system_c::get_status(sound_status &status) const {
+	fmod_errorcheck(FMOD_System_GetCPUUsage(fmod_system, &status.dsp_usage, &status.stream_usage, NULL, &status.update_usage, &status.total_usage));
+	FMOD_OPENSTATE open_state = FMOD_OPENSTATE_READY;
+	FMOD_BOOL starving = false, disk_busy = false;
+	fmod_errorcheck(FMOD_Sound_GetOpenState(music, &open_state, &status.percent_buffered, &starving, &disk_busy));
+	status.open_state = open_state;
+	status.starving = starving;
+	status.disk_busy = disk_busy;
+	fmod_errorcheck(FMOD_Memory_GetStats(&status.memory_used, &status.memory_max, false));
 }
 
-//This analyzes the spectrum of the music FMODs own features
-void sound_system_c::get_spectrum(float *spectrumL, float *spectrumR) const {
-	fmod_errorcheck(FMOD_Channel_GetSpectrum(channel, spectrumL, SPECTRUMSIZE, 0, FMOD_DSP_FFT_WINDOW_TRIANGLE));
-	fmod_errorcheck(FMOD_Channel_GetSpectrum(channel, spectrumR, SPECTRUMSIZE, 1, FMOD_DSP_FFT_WINDOW_TRIANGLE));
+unsigned int sound_system_c::get_error_count() {
+	return fmod_errors.load(std::memory_order_relaxed);
 }
 
 void sound_system_c::update() const {
+	scoped_trace_c trace("FMOD_System_Update");
 	fmod_errorcheck(FMOD_System_Update(fmod_system));
 }
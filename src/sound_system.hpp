@@ -6,6 +6,10 @@
 #define OUTPUTRATE 48000
 #define SPECTRUMSIZE 4096 //Defines the accuracy of the analyzed spectrum
 
+//Uncomment this to let FMOD analyze the spectrum instead of our own FFT
+//  this can be used for comparing the performance and results of the two
+//#define FMOD_SPECTRUM
+
 /// NOTE: if compiling FMOD gives you an error, try uncommenting the following line
 //#define REDEFINE_FMOD_STDCALL
 
@@ -18,8 +22,36 @@
 	#undef _stdcall
 #endif
 
+#include "fft.hpp"
+#include "dsp_tap.hpp"
+
+//Size of the ring buffer between FMODs mixer and the analysis in samples (about 0.7 seconds)
+#define TAP_CAPACITY 32768
+
+//What FMOD is doing, for finding out why a frame was late and for the metrics
+struct sound_status {
+	float dsp_usage, stream_usage, update_usage, total_usage; //Percents of a CPU core
+	int open_state; //FMOD_OPENSTATE of the stream
+	unsigned int percent_buffered;
+	bool starving, disk_busy;
+	int memory_used, memory_max; //Bytes allocated by FMOD now and at most
+
+	sound_status(): dsp_usage(0), stream_usage(0), update_usage(0), total_usage(0), open_state(0), percent_buffered(0),
+		starving(false), disk_busy(false), memory_used(0), memory_max(0) {}
+};
+
+//Where FMOD plays the music
+enum sound_output {
+	OUTPUT_DEVICE, //The audio device
+	OUTPUT_NOSOUND, //Nowhere but still in realtime, for machines without an audio device
+	OUTPUT_NRT, //Nowhere and only when update is called
+	OUTPUT_WAVWRITER_NRT //To a WAV file and only when update is called
+};
+
 /*
 	The class for initializing FMOD and playing and analyzing music
+	With OUTPUT_NRT and OUTPUT_WAVWRITER_NRT there is no audio device and the music is played only once
+	  FMOD then mixes the music only when update is called, so it can be analyzed faster than realtime
 */
 class sound_system_c {
 	private:
@@ -30,11 +62,33 @@ class sound_system_c {
 		FMOD_SOUND *music;
 		FMOD_CHANNEL *channel;
 
+		//Analysis of the played music
+		//The samples come from the DSP tap and waveL and waveR hold the latest window of them
+		dsp_tap_c tap;
+		stereo_sample *tap_samples;
+		fft_c fft;
+		float *waveL, *waveR;
+
+		double output_latency; //Seconds from mixing a sample to hearing it
+		float sound_rate; //The sample rate of the song, the PCM positions of the channel are in these samples
+		unsigned int length_pcm;
+
 	public:
-		sound_system_c(const char *song_name);
+		sound_system_c(const char *song_name, const sound_output output = OUTPUT_DEVICE, const char *wav_name = NULL);
 		~sound_system_c();
 		void play_music();
-		void get_spectrum(float *spectrumL, float *spectrumR) const;
+		void advance(const unsigned int samples = 0);
+		void get_spectrum(float *spectrumL, float *spectrumR);
+		unsigned int get_available_samples() const;
+		unsigned int get_position_ms() const;
+		unsigned int get_window_position() const;
+		double get_window_delay() const;
+		double get_output_latency() const { return output_latency; }
+		double get_sound_rate() const { return sound_rate; }
+		unsigned int get_length_ms() const;
+		bool is_playing() const;
+		void get_status(sound_status &status) const;
+		static unsigned int get_error_count();
 		void update() const;
 };
 
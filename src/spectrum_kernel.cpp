@@ -0,0 +1,82 @@
+/** spectrum_kernel.cpp **/
+
+#include <cmath>
+#include "spectrum_kernel.hpp"
+#include "simd.hpp"
+
+//size must be a multiple of SIMD_WIDTH
+spectrum_kernel_c::spectrum_kernel_c(const int size, const int smooth_start, const int smooth_end):
+	size(size),
+	bass_end((size / 128 + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH),
+	smooth_mask(simd_new_floats(size)),
+	side_weights(simd_new_floats(size)),
+	sound_weights(simd_new_floats(size)),
+	bass_weights(simd_new_floats(bass_end)) {
+
+	//The last bin is not included in the sums
+	for(int i = 0; i < size - 1; i++) {
+		side_weights[i] = sqrt(i);
+		sound_weights[i] = 1.0f;
+	}
+	for(int i = smooth_start; i < smooth_end; i++) smooth_mask[i] = 1.0f;
+	for(int i = 0; i < size / 128; i++) bass_weights[i] = (float)size / 128.0f - (float)i;
+}
+
+spectrum_kernel_c::~spectrum_kernel_c() {
+	simd_free(smooth_mask);
+	simd_free(side_weights);
+	simd_free(sound_weights);
+	simd_free(bass_weights);
+}
+
+//A 5 tap filter around the given bin
+inline simd_float smooth_bin(const float *p) {
+	return simd_add(simd_add(
+		simd_mul(simd_set1(0.1f), simd_add(simd_loadu(p - 2), simd_loadu(p + 2))),
+		simd_mul(simd_set1(0.2f), simd_add(simd_loadu(p - 1), simd_loadu(p + 1)))),
+		simd_mul(simd_set1(0.4f), simd_load(p)));
+}
+
+//Sweeps the bins from begin to end
+//sums are the bass, left, right and sound accumulators
+template<bool SMOOTH, bool BASS>
+inline void sweep(const int begin, const int end, const float *rawL, const float *rawR, float *spectrumL, float *spectrumR,
+	const float *smooth_mask, const float *side_weights, const float *sound_weights, const float *bass_weights, simd_float *sums) {
+
+	for(int i = begin; i < end; i+= SIMD_WIDTH) {
+		simd_float left = simd_load(rawL + i);
+		simd_float right = simd_load(rawR + i);
+		if(SMOOTH) {
+			//Selects either the smoothed or the raw value, both multipliers are exactly 0 or 1
+			const simd_float mask = simd_load(smooth_mask + i);
+			const simd_float inverse_mask = simd_sub(simd_set1(1.0f), mask);
+			left = simd_add(simd_mul(smooth_bin(rawL + i), mask), simd_mul(left, inverse_mask));
+			right = simd_add(simd_mul(smooth_bin(rawR + i), mask), simd_mul(right, inverse_mask));
+		}
+		simd_storeu(spectrumL + i, left);
+		simd_storeu(spectrumR + i, right);
+
+		const simd_float both = simd_add(left, right);
+		if(BASS) sums[0] = simd_add(sums[0], simd_mul(both, simd_load(bass_weights + i)));
+		const simd_float side_weight = simd_load(side_weights + i);
+		sums[1] = simd_add(sums[1], simd_mul(left, side_weight));
+		sums[2] = simd_add(sums[2], simd_mul(right, side_weight));
+		sums[3] = simd_add(sums[3], simd_mul(both, simd_load(sound_weights + i)));
+	}
+}
+
+//rawL and rawR are aligned and have SPECTRUM_PADDING zeros on both sides when SMOOTH is true
+//The output spectrums don't need to be aligned
+//The sums are not scaled
+template<bool SMOOTH>
+void spectrum_kernel_c::run(const float *rawL, const float *rawR, float *spectrumL, float *spectrumR, spectrum_sums &result) const {
+	simd_float sums[4] = {simd_set1(0.0f), simd_set1(0.0f), simd_set1(0.0f), simd_set1(0.0f)};
+	sweep<SMOOTH, true>(0, bass_end, rawL, rawR, spectrumL, spectrumR, smooth_mask, side_weights, sound_weights, bass_weights, sums);
+	sweep<SMOOTH, false>(bass_end, size, rawL, rawR, spectrumL, spectrumR, smooth_mask, side_weights, sound_weights, bass_weights, sums);
+	result.bass = simd_sum(sums[0]);
+	result.left = simd_sum(sums[1]);
+	result.right = simd_sum(sums[2]);
+	result.sound = simd_sum(sums[3]);
+}
+template void spectrum_kernel_c::run<true>(const float *rawL, const float *rawR, float *spectrumL, float *spectrumR, spectrum_sums &result) const;
+template void spectrum_kernel_c::run<false>(const float *rawL, const float *rawR, float *spectrumL, float *spectrumR, spectrum_sums &result) const;
@@ -0,0 +1,43 @@
+/** spectrum_kernel.hpp **/
+
+#ifndef SPECTRUM_KERNEL_HPP
+#define SPECTRUM_KERNEL_HPP
+
+//The raw spectrums must have this many readable floats before and after them for the smoothing
+//A multiple of SIMD_WIDTH so that the padded spectrums stay aligned
+#define SPECTRUM_PADDING 8
+
+//The sums that the squares and the background fade are made of
+struct spectrum_sums {
+	float bass;
+	float left;
+	float right;
+	float sound;
+};
+
+/*
+	Smooths the spectrum and calculates the sums from it in a single vectorized sweep
+	Every bin is loaded once and all the outputs are accumulated from the registers,
+	  so the spectrums are read from memory only once per frame
+	The per-bin weights of the sums and the range of the smoothing are precomputed aligned tables
+	  so the sweep has no branches or square roots
+*/
+class spectrum_kernel_c {
+	private:
+		spectrum_kernel_c(const spectrum_kernel_c &obj); //Copy constructor
+		spectrum_kernel_c &operator=(const spectrum_kernel_c &obj); //Assign operator
+
+		const int size;
+		int bass_end; //The bins with bass weights rounded up to SIMD_WIDTH
+		float *smooth_mask; //1 where the spectrum is smoothed and 0 elsewhere
+		float *side_weights; //Weights of the left and right sums
+		float *sound_weights; //Weights of the sound sum
+		float *bass_weights; //Weights of the bass sum, bass_end values
+
+	public:
+		spectrum_kernel_c(const int size, const int smooth_start, const int smooth_end);
+		~spectrum_kernel_c();
+		template<bool SMOOTH> void run(const float *rawL, const float *rawR, float *spectrumL, float *spectrumR, spectrum_sums &sums) const;
+};
+
+#endif
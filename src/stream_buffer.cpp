@@ -0,0 +1,72 @@
+/** stream_buffer.cpp **/
+
+#include <iostream>
+#include "stream_buffer.hpp"
+
+//The allocations are aligned for any vertex attribute type
+#define STREAM_ALIGNMENT 16
+
+stream_buffer_c::stream_buffer_c(const GLenum target, const size_t region_size):
+	target(target), region_size(region_size), fenced(GLEW_ARB_sync), region(0), used(0), mapped(NULL) {
+
+	for(int i = 0; i < STREAM_REGIONS; i++) fences[i] = 0;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(target, buffer);
+	glBufferData(target, fenced ? region_size * STREAM_REGIONS : region_size, NULL, GL_STREAM_DRAW);
+	if(!fenced) std::cerr << "WARNING: GL_ARB_sync not supported, the stream buffer is orphaned on every frame" << std::endl;
+}
+
+stream_buffer_c::~stream_buffer_c() {
+	for(int i = 0; i < STREAM_REGIONS; i++) {
+		if(fences[i]) glDeleteSync(fences[i]);
+	}
+	glDeleteBuffers(1, &buffer);
+}
+
+//Waits until the GPU is done with the next region and maps it for writing
+//Returns false if the mapping failed
+bool stream_buffer_c::begin_frame() {
+	glBindBuffer(target, buffer);
+	used = 0;
+	if(fenced) {
+		region = (region + 1) % STREAM_REGIONS;
+		if(fences[region]) {
+			//Usually the region was done long ago and this returns immediately
+			while(glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+			glDeleteSync(fences[region]);
+			fences[region] = 0;
+		}
+		mapped = (unsigned char*)glMapBufferRange(target, region * region_size, region_size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+	}
+	else {
+		mapped = (unsigned char*)glMapBufferRange(target, 0, region_size,
+			GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+	}
+	return mapped != NULL;
+}
+
+//Returns memory for size bytes of data in the current region and its offset from the start of the buffer
+//Returns NULL if the region is full or the buffer is not mapped
+void *stream_buffer_c::allocate(const size_t size, size_t &offset) {
+	const size_t start = (used + STREAM_ALIGNMENT - 1) / STREAM_ALIGNMENT * STREAM_ALIGNMENT;
+	if(!mapped || start + size > region_size) return NULL;
+	used = start + size;
+	offset = (fenced ? region * region_size : 0) + start;
+	return mapped + start;
+}
+
+//Unmaps the region so that the data can be drawn
+void stream_buffer_c::end_writing() {
+	if(!mapped) return;
+	glBindBuffer(target, buffer);
+	if(used > 0) glFlushMappedBufferRange(target, 0, used);
+	glUnmapBuffer(target);
+	mapped = NULL;
+}
+
+//Called after the last draw that uses the data of this frame
+void stream_buffer_c::end_frame() {
+	end_writing();
+	if(fenced) fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,44 @@
+/** stream_buffer.hpp **/
+
+#ifndef STREAM_BUFFER_HPP
+#define STREAM_BUFFER_HPP
+
+#include <cstddef>
+#include <GL/glew.h>
+
+//The amount of frames that can use the buffer at the same time
+//One more than the most frames in flight (see frame_pipeline.hpp)
+#define STREAM_REGIONS 4
+
+/*
+	A buffer for data that is written once per frame and then drawn
+	The buffer is split into a region per frame and a frame writes only to its own region
+	  with an unsynchronized mapping, so the driver never waits for the GPU to finish with the buffer
+	A fence after the draws of a frame guards the region until it comes around again
+	Without ARB_sync the whole buffer is orphaned on every frame instead
+*/
+class stream_buffer_c {
+	private:
+		stream_buffer_c(const stream_buffer_c &obj); //Copy constructor
+		stream_buffer_c &operator=(const stream_buffer_c &obj); //Assign operator
+
+		const GLenum target;
+		const size_t region_size;
+		const bool fenced;
+		GLuint buffer;
+		GLsync fences[STREAM_REGIONS];
+		int region;
+		size_t used;
+		unsigned char *mapped; //NULL when not mapped
+
+	public:
+		stream_buffer_c(const GLenum target, const size_t region_size);
+		~stream_buffer_c();
+		GLuint get_buffer() const { return buffer; }
+		bool begin_frame();
+		void *allocate(const size_t size, size_t &offset);
+		void end_writing();
+		void end_frame();
+};
+
+#endif
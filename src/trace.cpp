@@ -0,0 +1,99 @@
+/** trace.cpp **/
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include "trace.hpp"
+
+tracer_c tracer;
+
+//The buffer of the current thread, NULL until the thread records something
+//  and no_buffer if all the buffers were taken by then
+static thread_local void *current_buffer = NULL;
+static char no_buffer;
+
+tracer_c::tracer_c(): thread_amount(0), enabled(false) {
+	for(int i = 0; i < TRACE_THREADS; i++) {
+		threads[i].events = NULL;
+		threads[i].written.store(0, std::memory_order_relaxed);
+		threads[i].name = NULL;
+	}
+}
+
+tracer_c::~tracer_c() {
+	for(int i = 0; i < TRACE_THREADS; i++) delete [] threads[i].events;
+}
+
+//The events are recorded from now on, the thread that calls this is the main thread
+//All the buffers are allocated here so that recording never allocates, the FMOD mixer thread must not
+void tracer_c::start() {
+	for(int i = 0; i < TRACE_THREADS; i++) {
+		if(!threads[i].events) threads[i].events = new trace_event[TRACE_EVENTS];
+	}
+	start_time = std::chrono::steady_clock::now();
+	enabled.store(true);
+	set_thread_name("main");
+}
+
+//Takes a buffer for the thread when it records its first event
+//Returns NULL if all the buffers are taken, the thread doesn't try again after that
+tracer_c::thread_buffer *tracer_c::get_thread_buffer() {
+	if(current_buffer == &no_buffer) return NULL;
+	if(current_buffer) return (thread_buffer*)current_buffer;
+	const int index = thread_amount.fetch_add(1);
+	if(index >= TRACE_THREADS) {
+		current_buffer = &no_buffer;
+		return NULL;
+	}
+	current_buffer = &threads[index];
+	return &threads[index];
+}
+
+void tracer_c::add(const char *name, const trace_time begin, const trace_time end) {
+	thread_buffer *buffer = get_thread_buffer();
+	if(!buffer) return;
+	const uint64_t written = buffer->written.load(std::memory_order_relaxed);
+	const trace_event event = {name, begin, end};
+	buffer->events[written % TRACE_EVENTS] = event;
+	buffer->written.store(written + 1, std::memory_order_release);
+}
+
+//The name is shown for the events of the thread, only the first name of a thread is used
+void tracer_c::set_thread_name(const char *name) {
+	if(!is_enabled()) return;
+	thread_buffer *buffer = get_thread_buffer();
+	if(buffer && !buffer->name) buffer->name = name;
+}
+
+//Must be called after the traced threads have stopped
+bool tracer_c::write(const char *file_name) {
+	enabled.store(false);
+	std::ofstream file(file_name);
+	if(!file.is_open()) return false;
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	uint64_t events = 0;
+	const int amount = std::min(thread_amount.load(), TRACE_THREADS);
+	for(int i = 0; i < amount; i++) {
+		const thread_buffer &buffer = threads[i];
+		if(!first) file << ",\n";
+		first = false;
+		file << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << i << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << (buffer.name ? buffer.name : "thread") << "\"}}";
+
+		//Only the latest events are left when the buffer has gone around
+		const uint64_t written = buffer.written.load(std::memory_order_acquire);
+		for(uint64_t j = written > TRACE_EVENTS ? written - TRACE_EVENTS : 0; j < written; j++) {
+			const trace_event &event = buffer.events[j % TRACE_EVENTS];
+			file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << i << ",\"name\":\"" << event.name << "\",\"ts\":"
+				<< std::chrono::duration<double, std::micro>(event.begin - start_time).count() << ",\"dur\":"
+				<< std::chrono::duration<double, std::micro>(event.end - event.begin).count() << "}";
+			events++;
+		}
+	}
+	file << "\n]}\n";
+	std::cout << "Wrote " << events << " trace events of " << amount << " threads to " << file_name << std::endl;
+	return file.good();
+}
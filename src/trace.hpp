@@ -0,0 +1,77 @@
+/** trace.hpp **/
+
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+//The most threads that can be traced and the amount of the latest events that are kept for each of them
+#define TRACE_THREADS 16
+#define TRACE_EVENTS 65536
+
+typedef std::chrono::steady_clock::time_point trace_time;
+
+/*
+	Records what every thread does and when for --trace
+	Every thread writes the events to its own ring buffer without locks,
+	  the buffers are allocated by start and a thread takes one when it records its first event
+	The file is written in the trace event format of Chrome (chrome://tracing, ui.perfetto.dev)
+	  after all the traced threads have stopped
+	Nothing is recorded before start is called
+*/
+class tracer_c {
+	private:
+		tracer_c(const tracer_c &obj); //Copy constructor
+		tracer_c &operator=(const tracer_c &obj); //Assign operator
+
+		//A span of time, the names are literals
+		struct trace_event {
+			const char *name;
+			trace_time begin, end;
+		};
+
+		struct thread_buffer {
+			trace_event *events;
+			std::atomic<uint64_t> written;
+			const char *name;
+		};
+
+		thread_buffer threads[TRACE_THREADS];
+		std::atomic<int> thread_amount;
+		std::atomic<bool> enabled;
+		trace_time start_time;
+
+		thread_buffer *get_thread_buffer();
+
+	public:
+		tracer_c();
+		~tracer_c();
+		void start();
+		bool is_enabled() const { return enabled.load(std::memory_order_relaxed); }
+		void add(const char *name, const trace_time begin, const trace_time end);
+		void set_thread_name(const char *name);
+		bool write(const char *file_name);
+};
+
+//The tracer of the program
+extern tracer_c tracer;
+
+//Records an event from its construction to its destruction
+class scoped_trace_c {
+	private:
+		scoped_trace_c(const scoped_trace_c &obj); //Copy constructor
+		scoped_trace_c &operator=(const scoped_trace_c &obj); //Assign operator
+
+		const char *const name;
+		const trace_time begin;
+
+	public:
+		scoped_trace_c(const char *name): name(name), begin(std::chrono::steady_clock::now()) {}
+		~scoped_trace_c() {
+			if(tracer.is_enabled()) tracer.add(name, begin, std::chrono::steady_clock::now());
+		}
+};
+
+#endif
@@ -0,0 +1,49 @@
+/** triple_buffer.hpp **/
+
+#ifndef TRIPLE_BUFFER_HPP
+#define TRIPLE_BUFFER_HPP
+
+#include <atomic>
+
+/*
+	Wait-free triple buffer for one producer thread and one consumer thread
+	The producer writes to the back buffer and publishes it, the consumer reads the front buffer
+	  and the third one is swapped between them, so neither side ever waits for the other
+	The consumer always gets the newest published value and the values in between are skipped
+*/
+template<class T> class triple_buffer_c {
+	private:
+		triple_buffer_c(const triple_buffer_c &obj); //Copy constructor
+		triple_buffer_c &operator=(const triple_buffer_c &obj); //Assign operator
+
+		//Set in middle when it has been published but not taken by the consumer yet
+		static const int FRESH = 4;
+
+		T buffers[3];
+		int back; //Only used by the producer
+		alignas(64) std::atomic<int> middle; //The index of the buffer between the threads and FRESH
+		alignas(64) int front; //Only used by the consumer
+
+	public:
+		//All the buffers start as copies of initial, so they can have their memory allocated here
+		triple_buffer_c(const T &initial): back(0), middle(1), front(2) {
+			for(int i = 0; i < 3; i++) buffers[i] = initial;
+		}
+
+		//Producer side
+		T &get_back() { return buffers[back]; }
+		void publish() {
+			back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+		}
+
+		//Consumer side
+		//Takes the newest published buffer and returns false if nothing new was published
+		bool update() {
+			if(!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+			front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+			return true;
+		}
+		const T &get_front() const { return buffers[front]; }
+};
+
+#endif
@@ -0,0 +1,224 @@
+/** video_exporter.cpp **/
+
+#include <cstring>
+#include <algorithm>
+#include "video_exporter.hpp"
+#include "main.hpp"
+#include "trace.hpp"
+
+#define Y4M_FRAME_HEADER "FRAME\n"
+#define Y4M_FRAME_HEADER_SIZE 6
+
+enum {
+	SLOT_FREE,
+	SLOT_FILLING, //The main thread copies the pixels from a pixel buffer object
+	SLOT_FILLED,
+	SLOT_CONVERTING,
+	SLOT_CONVERTED,
+	SLOT_WRITING
+};
+
+inline bool ends_with(const char *text, const char *end) {
+	const size_t text_length = strlen(text);
+	const size_t end_length = strlen(end);
+	return text_length >= end_length && strcmp(text + text_length - end_length, end) == 0;
+}
+
+video_exporter_c::video_exporter_c(const GLuint screen_framebuffer, const int width, const int height, const char *file_name):
+	screen_framebuffer(screen_framebuffer),
+	width(width), height(height),
+	//The chroma planes of 4:2:0 have half the resolution rounded up
+	chroma_width((width + 1) / 2), chroma_height((height + 1) / 2),
+	y4m(!ends_with(file_name, ".rgba")),
+	output_size(y4m
+		? Y4M_FRAME_HEADER_SIZE + width * height + chroma_width * chroma_height * 2
+		: width * height * 4),
+	file(file_name, std::ios::out | std::ios::binary),
+	pbo_next(0), pbo_pending(0),
+	frames_submitted(0), frames_written(0),
+	finishing(false), finished(false) {
+
+	//Full range BT.601 like JPEG
+	if(y4m) file << "YUV4MPEG2 W" << width << " H" << height << " F" << (int)(FPS * 1000.0) << ":1000 Ip A1:1 C420jpeg\n";
+
+	glGenBuffers(EXPORT_PBO_AMOUNT, pbos);
+	for(int i = 0; i < EXPORT_PBO_AMOUNT; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	//The main thread renders and one thread writes, the rest of the cores convert
+	const int converter_amount = std::max((int)std::thread::hardware_concurrency() - 2, 1);
+	slots.resize(converter_amount + 3);
+	for(size_t i = 0; i < slots.size(); i++) {
+		slots[i].rgba = new unsigned char[width * height * 4];
+		slots[i].output = new unsigned char[output_size];
+		slots[i].number = -1;
+		slots[i].state = SLOT_FREE;
+	}
+	for(int i = 0; i < converter_amount; i++) converters.push_back(std::thread(&video_exporter_c::convert_frames, this));
+	writer = std::thread(&video_exporter_c::write_frames, this);
+}
+
+video_exporter_c::~video_exporter_c() {
+	finish();
+	glDeleteBuffers(EXPORT_PBO_AMOUNT, pbos);
+	for(size_t i = 0; i < slots.size(); i++) {
+		delete [] slots[i].rgba;
+		delete [] slots[i].output;
+	}
+}
+
+//Starts reading the current content of the screen framebuffer
+//The frame reaches the file a few frames later
+void video_exporter_c::capture() {
+	scoped_trace_c trace("capture");
+	if(pbo_pending == EXPORT_PBO_AMOUNT) retire_oldest_pbo();
+
+	//Only the read framebuffer is changed so drawing continues where it was
+	glBindFramebufferEXT(GL_READ_FRAMEBUFFER_EXT, screen_framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[pbo_next]);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	pbo_next = (pbo_next + 1) % EXPORT_PBO_AMOUNT;
+	pbo_pending++;
+}
+
+//Copies the oldest frame from the GPU to a free slot and gives it to the converters
+void video_exporter_c::retire_oldest_pbo() {
+	frame_slot *slot = NULL;
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while(!slot) {
+			for(size_t i = 0; i < slots.size() && !slot; i++) {
+				if(slots[i].state == SLOT_FREE) slot = &slots[i];
+			}
+			if(!slot) changed.wait(lock);
+		}
+		slot->state = SLOT_FILLING;
+		slot->number = frames_submitted++;
+	}
+
+	const int oldest = (pbo_next - pbo_pending + EXPORT_PBO_AMOUNT) % EXPORT_PBO_AMOUNT;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[oldest]);
+	const void *pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+	if(pixels) memcpy(slot->rgba, pixels, width * height * 4);
+	else memset(slot->rgba, 0, width * height * 4);
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	pbo_pending--;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		slot->state = SLOT_FILLED;
+	}
+	changed.notify_all();
+}
+
+//Converter thread, takes the oldest filled frame until everything is done
+void video_exporter_c::convert_frames() {
+	tracer.set_thread_name("converter");
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		frame_slot *slot = NULL;
+		for(size_t i = 0; i < slots.size(); i++) {
+			if(slots[i].state == SLOT_FILLED && (!slot || slots[i].number < slot->number)) slot = &slots[i];
+		}
+		if(!slot) {
+			if(finishing) return;
+			changed.wait(lock);
+			continue;
+		}
+		slot->state = SLOT_CONVERTING;
+		lock.unlock();
+		{
+			scoped_trace_c trace("convert_frame");
+			convert(*slot);
+		}
+		lock.lock();
+		slot->state = SLOT_CONVERTED;
+		changed.notify_all();
+	}
+}
+
+//Writer thread, writes the converted frames in order
+void video_exporter_c::write_frames() {
+	tracer.set_thread_name("writer");
+	std::unique_lock<std::mutex> lock(mutex);
+	while(true) {
+		frame_slot *slot = NULL;
+		for(size_t i = 0; i < slots.size(); i++) {
+			if(slots[i].state == SLOT_CONVERTED && slots[i].number == frames_written) slot = &slots[i];
+		}
+		if(!slot) {
+			if(finishing && frames_written == frames_submitted) return;
+			changed.wait(lock);
+			continue;
+		}
+		slot->state = SLOT_WRITING;
+		lock.unlock();
+		{
+			scoped_trace_c trace("write_frame");
+			file.write((const char*)slot->output, output_size);
+		}
+		lock.lock();
+		slot->state = SLOT_FREE;
+		frames_written++;
+		changed.notify_all();
+	}
+}
+
+//Turns the bottom-up RGBA of OpenGL into a top-down frame of the file
+void video_exporter_c::convert(const frame_slot &slot) const {
+	if(!y4m) {
+		for(int y = 0; y < height; y++) {
+			memcpy(slot.output + y * width * 4, slot.rgba + (height - 1 - y) * width * 4, width * 4);
+		}
+		return;
+	}
+
+	memcpy(slot.output, Y4M_FRAME_HEADER, Y4M_FRAME_HEADER_SIZE);
+	unsigned char *luma = slot.output + Y4M_FRAME_HEADER_SIZE;
+	unsigned char *cb = luma + width * height;
+	unsigned char *cr = cb + chroma_width * chroma_height;
+
+	//The coefficients are in 16.16 fixed point
+	for(int y = 0; y < height; y++) {
+		const unsigned char *row = slot.rgba + (height - 1 - y) * width * 4;
+		for(int x = 0; x < width; x++) {
+			const int r = row[x * 4], g = row[x * 4 + 1], b = row[x * 4 + 2];
+			luma[y * width + x] = (19595 * r + 38470 * g + 7471 * b + 32768) >> 16;
+		}
+	}
+	//Chroma is averaged over 2x2 pixels, the last row and column are repeated for odd sizes
+	for(int y = 0; y < chroma_height; y++) {
+		const unsigned char *row1 = slot.rgba + (height - 1 - y * 2) * width * 4;
+		const unsigned char *row2 = slot.rgba + (height - 1 - std::min(y * 2 + 1, height - 1)) * width * 4;
+		for(int x = 0; x < chroma_width; x++) {
+			const int x1 = x * 2 * 4;
+			const int x2 = std::min(x * 2 + 1, width - 1) * 4;
+			const int r = row1[x1] + row1[x2] + row2[x1] + row2[x2];
+			const int g = row1[x1 + 1] + row1[x2 + 1] + row2[x1 + 1] + row2[x2 + 1];
+			const int b = row1[x1 + 2] + row1[x2 + 2] + row2[x1 + 2] + row2[x2 + 2];
+			cb[y * chroma_width + x] = (-11059 * r - 21709 * g + 32768 * b + (128 << 18) + (1 << 17)) >> 18;
+			cr[y * chroma_width + x] = (32768 * r - 27439 * g - 5329 * b + (128 << 18) + (1 << 17)) >> 18;
+		}
+	}
+}
+
+//Waits until every captured frame is in the file
+void video_exporter_c::finish() {
+	if(finished) return;
+	while(pbo_pending > 0) retire_oldest_pbo();
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		finishing = true;
+	}
+	changed.notify_all();
+	for(size_t i = 0; i < converters.size(); i++) converters[i].join();
+	writer.join();
+	file.close();
+	finished = true;
+}
@@ -0,0 +1,68 @@
+/** video_exporter.hpp **/
+
+#ifndef VIDEO_EXPORTER_HPP
+#define VIDEO_EXPORTER_HPP
+
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <GL/glew.h>
+
+//The amount of frames that are being read back from the GPU at the same time
+#define EXPORT_PBO_AMOUNT 3
+
+/*
+	Writes the rendered frames to a Y4M video or to raw RGBA frames if the file name ends with .rgba
+	The frames are read from the GPU through a ring of pixel buffer objects,
+	  so glReadPixels returns immediately and the pixels are mapped only when the ring has gone around
+	The colour conversion is done by worker threads and a writer thread writes the frames in order
+*/
+class video_exporter_c {
+	private:
+		video_exporter_c(const video_exporter_c &obj); //Copy constructor
+		video_exporter_c &operator=(const video_exporter_c &obj); //Assign operator
+
+		//A frame on its way from the GPU to the file
+		struct frame_slot {
+			unsigned char *rgba;
+			unsigned char *output;
+			int number; //The position of the frame in the video
+			int state;
+		};
+
+		const GLuint screen_framebuffer;
+		const int width, height;
+		const int chroma_width, chroma_height;
+		const bool y4m; //Otherwise raw RGBA
+		const unsigned int output_size; //Bytes per frame in the file
+		std::ofstream file;
+
+		//Asynchronous readback
+		GLuint pbos[EXPORT_PBO_AMOUNT];
+		int pbo_next, pbo_pending;
+
+		//The frames and the threads working on them
+		std::vector<frame_slot> slots;
+		std::vector<std::thread> converters;
+		std::thread writer;
+		std::mutex mutex;
+		std::condition_variable changed;
+		int frames_submitted, frames_written;
+		bool finishing, finished;
+
+		void retire_oldest_pbo();
+		void convert_frames();
+		void write_frames();
+		void convert(const frame_slot &slot) const;
+
+	public:
+		video_exporter_c(const GLuint screen_framebuffer, const int width, const int height, const char *file_name);
+		~video_exporter_c();
+		bool is_open() const { return file.is_open(); }
+		void capture();
+		void finish();
+};
+
+#endif
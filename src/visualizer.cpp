@@ -1,306 +1,346 @@
 /** visualizer.cpp **/
 
 #include <iostream>
-#include <cstring>
-#include <cmath>
+#include <algorithm>
 #include <GL/glew.h>
-#include <GL/glfw.h>
 #include "visualizer.hpp"
+#include "main.hpp"
+#include "clock.hpp"
+#include "allocation_counter.hpp"
+#include "video_exporter.hpp"
+#include "profiler.hpp"
+
+//The motion blur of the squares goes from the current size past the previous size
+//  this is how many times the change from the previous frame it covers
+#define SQUARE_BLUR_LENGTH 1.9f
+
+//The width of the squares relative to their height at the default window size
+//The squares keep their shape when the size of the window changes
+#define SQUARE_WIDTH_RATIO 0.56f
+
+//How fast the estimate of the display latency follows the measured swap times, from 0 to 1
+#define DISPLAY_LATENCY_SMOOTHING 0.1
+
+//The palette indices of the drawn things
+enum {
+	COLOR_BARS,
+	COLOR_BACKGROUND,
+	COLOR_SQUARES
+};
+
+//The layers of the render commands, drawn in this order
+enum {
+	LAYER_BARS,
+	LAYER_BACKGROUND,
+	LAYER_SQUARES
+};
+
+visualizer_c::visualizer_c(display_c &display, const char *song_name, const bool use_cache, const analyzer_settings &settings, const sound_output output, const char *wav_name, const int frames_in_flight, const double fps):
+	display(display),
+	graphics(display.get_width(), display.get_height(), display.get_screen_framebuffer()),
+	sound_system(song_name, output, wav_name),
+	analyzer(settings),
+	//The cache doesn't have the spectrum that the GPU bars need
+	cache(use_cache && !settings.gpu_bars ? new analysis_cache_c(song_name, sound_system.get_length_ms(), settings, analyzer.get_bar_amount()) : NULL),
+	gpu_bars(settings.gpu_bars ? new gpu_bars_c(analyzer) : NULL),
+	pipeline(frames_in_flight),
+	pacer(fps),
+	analysis_thread(sound_system, analyzer),
+	analysis_history(analyzer),
+	drawn_analysis(analyzer),
+	prepare_time(0), display_latency(1.0 / fps), av_latency(0), av_latency_sum(0), av_latency_frames(0),
+	exported_analysis(analyzer),
+	current_frame(0) {
+
+	const frame_state empty_frame = {0, 0, 0, {0, 0}, {0, 0}, {0, 0}};
+	frames[0] = frames[1] = empty_frame;
+
+	analyzer.set_cache(cache);
+	if(gpu_bars) gpu_bars->set_color(1.0, 0.1, 1.0, 1.0);
 
-#define FPS 60.0 //Frames per second
+	//Some drawing information
+	graphics.set_palette_color(COLOR_BARS, 1.0, 0.1, 1.0, 1.0);
+	graphics.set_palette_color(COLOR_BACKGROUND, 1.0, 0.0, 1.0, 0.3);
+	graphics.set_palette_color(COLOR_SQUARES, 1.0, 1.0, 1.0, 1.0);
+}
 
-#define MOTION_BLUR_AMOUNT 0.25f //Amount of "motion blur" in range from 0 to 1
+visualizer_c::~visualizer_c() {
+	delete cache;
+	delete gpu_bars;
+}
 
-//Defines the way the bars are drawn
-//in type 1 multiple bars are combined into one or one bar is broken into multiple bars so that all the drawn parts have same width
-//in type 2 all the existing bars are drawn with a variable width
-#define BAR_TYPE 1
+//Reports how many OpenGL state changes the frames needed and how many the state cache skipped
+void visualizer_c::print_state_changes(const int frames) const {
+	if(frames <= 0) return;
+	const gl_state_c &state = graphics.get_state();
+	std::cout << "OpenGL state changes per frame: " << (double)state.get_calls() / frames << " made, "
+		<< (double)state.get_elided_calls() / frames << " skipped as redundant" << std::endl;
+}
 
-#define SMOOTH_SPEC //Does some smoothing to the spectrum itself
-#define SMOOTH_BARS //Does some smoothing to the bars, does basically the same as SMOOTH_SPEC when BAR_TYPE is 2
+//Reports how long the CPU waited for the GPU to finish the frames in flight
+void visualizer_c::print_pipeline_waits(const int frames) const {
+	if(frames <= 0) return;
+	std::cout << "Waited for the GPU " << pipeline.get_wait_time() / frames * 1000.0 << " ms per frame with "
+		<< pipeline.get_frames_in_flight() << " frames in flight" << std::endl;
+}
 
-//Returns values linearly from y1 to y2 when x has values from x1 to x2
-inline float mix(const float x1, const float x2, const float y1, const float y2, const float x) {
-	return (y1 - y2) / (x1 - x2) * (x - x1) + y1;
+//Prints the GPU times of the passes and whether the GPU or the CPU limits the frame rate
+//The CPU time is the median frame without the waiting for the GPU, the swap and the pacing
+void visualizer_c::print_bottleneck() const {
+	const gpu_profiler_c &gpu_profiler = graphics.get_gpu_profiler();
+	if(gpu_profiler.get_frame_histogram().get_count() == 0) return;
+	gpu_profiler.print();
+	const double gpu_time = gpu_profiler.get_frame_histogram().get_percentile(50) / 1000000.0;
+	double cpu_time = profiler.get_histogram(STAGE_FRAME).get_percentile(50);
+	const profile_stage waits[] = {STAGE_PIPELINE_WAIT, STAGE_SWAP, STAGE_PACING};
+	for(int i = 0; i < 3; i++) cpu_time-= profiler.get_histogram(waits[i]).get_percentile(50);
+	cpu_time = std::max(cpu_time, 0.0) / 1000000.0;
+	std::cout << "The GPU works " << gpu_time << " ms and the CPU " << cpu_time << " ms per frame, so the frames are "
+		<< (gpu_time > cpu_time ? "limited by the GPU (fill-bound)" : "limited by the CPU") << std::endl;
 }
 
-visualizer_c::visualizer_c(const char *song_name):
-	sound_system(song_name) {}
+//The amount of frames in one play through of the song at the target frame rate
+int visualizer_c::get_song_frames() const {
+	return sound_system.get_length_ms() * pacer.get_fps() / 1000.0;
+}
 
-/*
-	A lot of the actual initialization is done here before the loop is started to keep things simple
-	First figures out how to draw the bars using logarithmic scale as FMOD gives spectrum data in linear scale
-	Then in the loop it mainly figures out what to draw
-*/
-void visualizer_c::run() {
-	//Some drawing information
-	const float bars_color[VERTEX_ARRAY_SIZE * 2]    = {1.0, 0.1, 1.0, 1.0, 1.0, 0.1, 1.0, 1.0};
-	const float bg_colors[VERTEX_ARRAY_SIZE * 2]     = {1.0, 0.3, 1.0, 0.3, 1.0, 0.0, 1.0, 0.0};
-	const float square_colors[VERTEX_ARRAY_SIZE * 2] = {0.05, 1.0, 0.05, 1.0, 0.05, 1.0, 0.05, 1.0};
-	const float fade_colors[VERTEX_ARRAY_SIZE * 2]   = {0.0, 1.0f - MOTION_BLUR_AMOUNT, 0.0, 1.0f - MOTION_BLUR_AMOUNT, 0.0, 1.0f - MOTION_BLUR_AMOUNT, 0.0, 1.0f - MOTION_BLUR_AMOUNT};
-	const float full_screen_vertices[VERTEX_ARRAY_SIZE * 2] = {
-		-1, -1,
-		 1, -1,
-		-1,  1,
-		 1,  1};
-
-	//Rather useless defines
-	#define SPECTRUMRANGE ((float)OUTPUTRATE / 2.0f) // 24000.0 Hz
-	#define BINSIZE (SPECTRUMRANGE / (float)SPECTRUMSIZE) // 5.8594 Hz
-
-	//We do not show the full spectrum, instead just the interesting part
-	#define SPECTRUM_START 6 // 41.0156 Hz  (7 * BINSIZE)
-	#define SPECTRUM_END 2560 // 15000.0 Hz  (2560 * BINSIZE)
-	//Storages for the left and right spectrums
-	float spectrumL[SPECTRUMSIZE];
-	float spectrumR[SPECTRUMSIZE];
-
-	//Bars 1 have constant width
-	//This figures out how to combine or divide the bars on the linear scale
-	//  so that they use logarithmic scale instead
-	#if BAR_TYPE == 1
-		#define BAR_MULT 1.022 //Affects the amount of bars
-		int bar_amount = 0; //The amount of bars
-		float i = BAR_MULT - 1;
-		float start = 0;
-		while(start + i <= SPECTRUMSIZE - 1) {
-			if(start >= SPECTRUM_START && start + i <= SPECTRUM_END) bar_amount++;
-			start+= i;
-			i*= BAR_MULT;
+//Writes everything that is drawn from the given analysis results
+//Every layer is drawn with one batch of rectangles
+//All the batches are written at once so the rectangle buffer is mapped only once per frame
+//The GPU may still be drawing the previous frames while this is done
+void visualizer_c::prepare_frame(const analysis_frame &analysis) {
+	scoped_timer_c timer(STAGE_PREPARE);
+	const frame_state &prev = frames[current_frame];
+	current_frame = 1 - current_frame;
+	frame_state &frame = frames[current_frame];
+	frame.bass_sum = analysis.bass_sum;
+	frame.left_sum = analysis.left_sum;
+	frame.right_sum = analysis.right_sum;
+	const float sound_sum = analysis.sound_sum;
+	rect_instance *rects;
+
+	//The window may have been resized
+	const int width = display.get_width();
+	const int height = display.get_height();
+	graphics.resize(width, height);
+	graphics.begin_frame();
+
+	//The bars, unless the GPU calculates them
+	const int bar_amount = analyzer.get_bar_amount();
+	const float *bar_heights = analysis.bar_heights.data();
+	const float *bar_positions = analyzer.get_bar_positions();
+	frame.bar_batch.amount = 0;
+	if(!gpu_bars && (rects = graphics.allocate_rects(bar_amount, frame.bar_batch))) {
+		for(int i = 0; i < bar_amount; i++) {
+			rects[i] = make_rect(bar_positions[i], -1.0f, bar_positions[i + 1], -1.0f + bar_heights[i], COLOR_BARS);
 		}
+	}
 
-		int *bar_start = new int[bar_amount]; //Start of full frequencies
-		int *bar_end = new int[bar_amount]; //End of full frequencies
-		int *bar_first = new int[bar_amount]; //First non-full frequency
-		float *bar_first_mult = new float[bar_amount]; //Mult for first non-full frequency
-		int *bar_last = new int[bar_amount]; //Last non-full frequency
-		float *bar_last_mult = new float[bar_amount]; //Mult for last non-full frequency
-
-		i = BAR_MULT - 1;
-		start = 0;
-		while(start < SPECTRUM_START) { //Skip some frequencies
-			start+= i;
-			i*= BAR_MULT;
-		}
-		for(int j = 0; j < bar_amount; j++) {
-			const float end = start + i;
-			bar_start[j] = ceil(start);
-			bar_end[j] = floor(end);
-			bar_first[j] = floor(start);
-			bar_first_mult[j] = bar_start[j] == bar_first[j] ? 0.0 : 1.0 - start + floor(start);
-			bar_last[j] = floor(end);
-			bar_last_mult[j] = end - floor(end);
-			if(bar_first[j] == bar_last[j]) {
-				bar_first_mult[j] = end - start;
-				bar_last_mult[j] = 0.0;
-			}
-			start+= i;
-			i*= BAR_MULT;
-		}
-	#endif
-
-	//Bars 2 have variable width
-	//This figures widths for the bars so that are on a logarithmic scale
-	#if BAR_TYPE == 2
-		float bar_size[SPECTRUMSIZE - 1];
-		float total_size = 0;
-		for(int i = 0; i < SPECTRUMSIZE - 1; i++) {
-			bar_size[i] = log(i + 2) - log(i + 1);
-			if(i >= SPECTRUM_START && i < SPECTRUM_END) total_size+= bar_size[i];
-		}
-		for(int i = 0; i < SPECTRUMSIZE - 1; i++) bar_size[i]*= 2.0 / total_size;
-	#endif
+	//The background fade at the top of the window
+	const float y = 1.0 - sound_sum / 10.0;
+	if((rects = graphics.allocate_rects(1, frame.bg_batch))) rects[0] = make_rect(-1, y, 1, 1, COLOR_BACKGROUND);
+
+	//The squares with some actual motion blur
+	square_instance *squares;
+	const float width_ratio = SQUARE_WIDTH_RATIO * ((float)WINDOW_WIDTH / WINDOW_HEIGHT) * ((float)height / std::max(width, 1));
+	if((squares = graphics.allocate_squares(3, frame.square_batch))) {
+		const square_instance bass_square = {0.0f, 0.1f, width_ratio, frame.bass_sum, frame.bass_sum + (prev.bass_sum - frame.bass_sum) * SQUARE_BLUR_LENGTH, COLOR_SQUARES, 0};
+		const square_instance left_square = {-0.6f, 0.5f, width_ratio, frame.left_sum, frame.left_sum + (prev.left_sum - frame.left_sum) * SQUARE_BLUR_LENGTH, COLOR_SQUARES, 0};
+		const square_instance right_square = {0.6f, 0.5f, width_ratio, frame.right_sum, frame.right_sum + (prev.right_sum - frame.right_sum) * SQUARE_BLUR_LENGTH, COLOR_SQUARES, 0};
+		squares[0] = bass_square;
+		squares[1] = left_square;
+		squares[2] = right_square;
+	}
+
+	graphics.end_writing();
+	if(gpu_bars) gpu_bars->update(analysis.spectrum.data());
+}
 
-	//Start playing the song
+//Draws the prepared frame to the screen framebuffer
+//The draws are recorded to the render queue and graphics_c decides their order within the layers
+void visualizer_c::submit_frame() {
+	const frame_state &frame = frames[current_frame];
+
+	//Draw everything, then show the frame and do the "motion blur"
+	render_queue.add(gpu_bars ? gpu_bars->command(LAYER_BARS, "bars") : graphics.rect_command(LAYER_BARS, BLEND_ALPHA, frame.bar_batch, "bars"));
+	render_queue.add(graphics.rect_command(LAYER_BACKGROUND, BLEND_ALPHA, frame.bg_batch, "background"));
+	render_queue.add(graphics.square_command(LAYER_SQUARES, BLEND_ADDITIVE, frame.square_batch, "squares"));
+	render_queue.add(graphics.present_command());
+	graphics.submit(render_queue);
+	graphics.end_frame();
+}
+
+//Prepares the next frame when the GPU has room for it
+//The results of the analysis are taken for the moment when the frame is expected to reach the screen,
+//  so the frame shows the sound that is heard at the same time if it has been analyzed already
+void visualizer_c::prepare_next_frame() {
+	if(analysis_thread.update()) analysis_history.push(analysis_thread.get_frame());
+	{
+		scoped_timer_c timer(STAGE_PIPELINE_WAIT);
+		pipeline.begin_frame();
+	}
+	prepare_time = get_time();
+	const double present_time = prepare_time + display_latency;
+	analysis_history.get(present_time, drawn_analysis);
+	av_latency = present_time - drawn_analysis.audible_time;
+	av_latency_sum+= av_latency;
+	av_latency_frames++;
+	prepare_frame(drawn_analysis);
+}
+
+//The average of how much later the frames were shown than their sound was heard in seconds
+//Negative when the frames were shown before their sound
+double visualizer_c::get_av_latency() const {
+	return av_latency_frames > 0 ? av_latency_sum / av_latency_frames : 0.0;
+}
+
+//Reports the latencies that the compensation works with
+void visualizer_c::print_latency() const {
+	if(av_latency_frames <= 0) return;
+	std::cout << "Latency: " << sound_system.get_output_latency() * 1000.0 << " ms in the audio output, "
+		<< display_latency * 1000.0 << " ms from preparing a frame to showing it" << std::endl;
+	std::cout << "  The frames were shown " << get_av_latency() * 1000.0 << " ms after their sound was heard" << std::endl;
+}
+
+/*
+	The analysis of the music is done by analyzer_c in the analysis thread
+	Here in the loop it mainly figures out what to draw from the newest results of the thread
+	The frames are drawn at the rate of the frame pacer which can differ from the rate of the analysis
+	The frames are pipelined: when more than one frame can be in flight (see frame_pipeline.hpp)
+	  the next frame is prepared right after the swap while the GPU is still drawing the last one
+	  otherwise it is prepared after the sleep so that it shows the music as late as possible
+	The loop ends when the display is closed or after frame_limit frames if it is not 0
+	The last frame is saved to screenshot_name if it is not NULL
+*/
+void visualizer_c::run(const int frame_limit, const char *screenshot_name) {
+	//Start playing and analyzing the song
 	sound_system.play_music();
+	analysis_thread.start();
+	pacer.start();
+	const bool prepare_early = pipeline.get_frames_in_flight() > 1;
+	bool prepared = false;
+	int frames = 0;
 
-	//Some variables for the motion blur of the squares
-	float prev_bass = 0;
-	float prev_left = 0;
-	float prev_right = 0;
-	double time = glfwGetTime();
+	//Nothing should be allocated in the loop after the first frames
+	allocation_checker_c allocation_checker;
 
 	//The actual loop starts here
-	while(!glfwGetKey(GLFW_KEY_ESC) && glfwGetWindowParam(GLFW_OPENED)) {
-		//Get spectrum
-		sound_system.get_spectrum(spectrumL, spectrumR);
-		float bass_sum = 0;
-		float left_sum = 0;
-		float right_sum = 0;
-		float sound_sum = 0;
-
-		//Smooth the actual spectrum
-		#ifdef SMOOTH_SPEC
-			float temp_spectrumL[SPECTRUMSIZE];
-			float temp_spectrumR[SPECTRUMSIZE];
-			memcpy(temp_spectrumL, spectrumL, sizeof(float) * SPECTRUMSIZE);
-			memcpy(temp_spectrumR, spectrumR, sizeof(float) * SPECTRUMSIZE);
-			for(int i = SPECTRUM_START; i < SPECTRUM_END; i++) {
-				spectrumL[i]
-					= 0.1 * (temp_spectrumL[i - 2] + temp_spectrumL[i + 2])
-					+ 0.2 * (temp_spectrumL[i - 1] + temp_spectrumL[i + 1])
-					+ 0.4 * temp_spectrumL[i];
-				spectrumR[i]
-					= 0.1 * (temp_spectrumR[i - 2] + temp_spectrumR[i + 2])
-					+ 0.2 * (temp_spectrumR[i - 1] + temp_spectrumR[i + 1])
-					+ 0.4 * temp_spectrumR[i];
-			}
-		#endif
+	while(display.is_open() && (frame_limit == 0 || frames < frame_limit)) {
+		scoped_timer_c frame_timer(STAGE_FRAME);
+		if(!prepared) prepare_next_frame();
+		frames++;
+
+		//Draw and swap the screen
+		submit_frame();
+		if(screenshot_name && frames == frame_limit) break; //The screenshot is taken before the swap
+		{
+			scoped_timer_c timer(STAGE_SWAP);
+			display.swap_buffers();
+		}
+		pipeline.end_frame();
+		pacer.end_frame();
 
-		//Draw some black color with some alpha over the previous frame
-		//This produces some "motion blur"
-		graphics.draw_arrays(full_screen_vertices, fade_colors);
+		//The frame is on its way to the screen when the swap returns
+		display_latency+= (get_time() - prepare_time - display_latency) * DISPLAY_LATENCY_SMOOTHING;
 
-		//Calculate the size for the middle bass square
-		for(int i = 0; i < SPECTRUMSIZE / 128; i++) {
-			bass_sum+= (spectrumL[i] + spectrumR[i]) * ((float)SPECTRUMSIZE / 128.0 - (float)i);
-		}
-		bass_sum/= 150.0;
-
-		//Calculate the sizes for the left and right squares
-		for(int i = 0; i < SPECTRUMSIZE - 1; i++) {
-			const float mult = sqrt(i);
-			left_sum+= spectrumL[i] * mult;
-			right_sum+= spectrumR[i] * mult;
-			sound_sum+= spectrumL[i] + spectrumR[i];
-		}
-		left_sum/= 800.0;
-		right_sum/= 800.0;
-
-		/*
-			Next calculate and draw the bars
-		*/
-		#if BAR_TYPE == 1 //Bars with constant width
-			float *bar1_heights = new float[bar_amount];
-			//Calculate the heights for the bars
-			for(int i = 0; i < bar_amount; i++) {
-				float sumL = spectrumL[bar_first[i]] * bar_first_mult[i] + spectrumL[bar_last[i]] * bar_last_mult[i];
-				float sumR = spectrumR[bar_first[i]] * bar_first_mult[i] + spectrumR[bar_last[i]] * bar_last_mult[i];
-
-				for(int j = bar_start[i]; j < bar_last[i]; j++) {
-					sumL+= spectrumL[j - 1];
-					sumR+= spectrumR[j - 1];
-				}
-
-				bar1_heights[i] = std::max((sumL + sumR) * 5.0 - 0.04, 0.0) + 0.015;
-			}
-			//Draw the bars
-			for(int i = 0; i < bar_amount; i++) {
-				const float x = -1.0 + (float)i / (float)bar_amount * 2.0;
-				const float x2 = -1.0 + float(i + 1) / (float)bar_amount * 2.0;
-
-				//Smooth the bars here
-				#ifdef SMOOTH_BARS
-					const float height
-						= 0.038 * (bar1_heights[std::max(i - 2, 0)] + bar1_heights[std::min(i + 2, bar_amount - 1)])
-						+ 0.154 * (bar1_heights[std::max(i - 1, 0)] + bar1_heights[std::min(i + 1, bar_amount - 1)])
-						+ 0.615 * bar1_heights[i];
-				#else
-					const float height = bar1_heights[i];
-				#endif
-
-				//Here we actually draw
-				const float vertices[VERTEX_ARRAY_SIZE * 2] = {
-					x,  -1.0f,
-					x,  -1.0f + height,
-					x2, -1.0f,
-					x2, -1.0f + height};
-				graphics.draw_arrays(vertices, bars_color);
-			}
-			delete [] bar1_heights;
-		#endif
-
-		#if BAR_TYPE == 2 //Bars with variable width
-			float pos = -1;
-			for(int i = SPECTRUM_START; i < SPECTRUM_END; i++) {
-				//Smooth the bars first
-				#ifdef SMOOTH_BARS
-					const float height = std::max((
-						  (0.038 * (spectrumL[i - 2] + spectrumL[i + 2])
-							+ 0.154 * (spectrumL[i - 1] + spectrumL[i + 1])
-							+ 0.615 * spectrumL[i])
-						+ (0.038 * (spectrumR[i - 2] + spectrumR[i + 2])
-							+ 0.154 * (spectrumR[i - 1] + spectrumR[i + 1])
-							+ 0.615 * spectrumR[i])
-						) / bar_size[i] * 0.05 - 0.04, 0.0) + 0.015;
-				#else
-					const float height = std::max((spectrumL[i] + spectrumR[i]) / bar_size[i] * 0.05 - 0.04, 0.0) + 0.015;
-				#endif
-				const float x2 = pos + bar_size[i];
-
-				//Here we actually draw
-				const float vertices[VERTEX_ARRAY_SIZE * 2] = {
-					pos, -1.0f,
-					pos, -1.0f + height,
-					x2,  -1.0f,
-					x2,  -1.0f + height};
-				graphics.draw_arrays(vertices, bars_color);
-
-				pos+= bar_size[i];
-			}
-		#endif
-
-		//Draw the background fade at the top of the window
-		const float y = 1.0 - sound_sum / 10.0;
-		const float bg_vertices[VERTEX_ARRAY_SIZE * 2] = {
-			-1, 1,
-			 1, 1,
-			-1, y,
-			 1, y};
-		graphics.draw_arrays(bg_vertices, bg_colors);
-
-		//Draw the squares with some actual motion blur
-		glBlendFunc(GL_ONE, GL_ONE); //Additive rendering
-		for(int i = 0; i < 20; i++) {
-			float size = mix(0, 10, bass_sum, prev_bass, i);
-			const float vertices1[VERTEX_ARRAY_SIZE * 2] = {
-				-size * 0.56f, 0.1f - size,
-				 size * 0.56f, 0.1f - size,
-				-size * 0.56f, 0.1f + size,
-				 size * 0.56f, 0.1f + size};
-			graphics.draw_arrays(vertices1, square_colors);
-
-			size = mix(0, 10, left_sum, prev_left, i);
-			const float vertices2[VERTEX_ARRAY_SIZE * 2] = {
-				-0.6f - size * 0.56f, 0.5f - size,
-				-0.6f + size * 0.56f, 0.5f - size,
-				-0.6f - size * 0.56f, 0.5f + size,
-				-0.6f + size * 0.56f, 0.5f + size};
-			graphics.draw_arrays(vertices2, square_colors);
-
-			size = mix(0, 10, right_sum, prev_right, i);
-			const float vertices3[VERTEX_ARRAY_SIZE * 2] = {
-				0.6f - size * 0.56f, 0.5f - size,
-				0.6f + size * 0.56f, 0.5f - size,
-				0.6f - size * 0.56f, 0.5f + size,
-				0.6f + size * 0.56f, 0.5f + size};
-			graphics.draw_arrays(vertices3, square_colors);
+		//The next frame while the GPU works on this one
+		prepared = prepare_early && (frame_limit == 0 || frames < frame_limit);
+		if(prepared) prepare_next_frame();
+
+		//Handle frames per second
+		{
+			scoped_timer_c timer(STAGE_PACING);
+			pacer.wait();
 		}
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); //"normal" rendering
 
-		//Do the "motion blur" and swap the screen
-		graphics.draw_framebuffer();
-		glfwSwapBuffers();
+		frame_timer.stop();
+		profiler.end_frame();
+		const double song_position = drawn_analysis.window_position / sound_system.get_sound_rate();
+		hitch_recorder.record(drawn_analysis.sound, song_position);
+		metrics_server.publish(frames, pacer.get_missed_deadlines(), pacer.get_dropped_deadlines(), song_position, drawn_analysis.sound);
+		metrics_server.publish_latency(av_latency, sound_system.get_output_latency(), display_latency);
+		allocation_checker.end_frame();
+	}
+	analysis_thread.stop();
+	hitch_recorder.stop();
+	metrics_server.stop();
+
+	if(screenshot_name && frames == frame_limit) {
+		if(display.save_screenshot(screenshot_name)) std::cout << "Saved the last frame to " << screenshot_name << std::endl;
+		else std::cerr << "Couldn't save the screenshot to " << screenshot_name << std::endl;
+	}
+
+	const int analyzed_frames = analysis_thread.get_frames();
+	if(analyzed_frames > 0) std::cout << "Average analysis time: " << analysis_thread.get_analysis_time() / analyzed_frames * 1000.0 << " ms" << std::endl;
+	print_state_changes(frames);
+	print_pipeline_waits(frames);
+	pacer.print_statistics();
+	hitch_recorder.print_statistics();
+	print_latency();
+	profiler.print();
+	print_bottleneck();
+}
 
-		//Save values for the next frame
-		prev_bass = bass_sum;
-		prev_left = left_sum;
-		prev_right = right_sum;
+//Writes the frames around the frames that take over threshold periods of the frame rate to directory when playing in realtime
+void visualizer_c::record_hitches(const char *directory, const double threshold) {
+	hitch_recorder.start(directory, threshold, pacer.get_fps());
+}
 
-		sound_system.update();
+//Serves the metrics on the Unix domain socket at path when playing in realtime
+bool visualizer_c::serve_metrics(const char *path) {
+	return metrics_server.start(path);
+}
 
-		//Handle frames per second
-		time+= 1.0 / FPS;
-		const double sleep = time - glfwGetTime();
-		if(sleep > 0.0) glfwSleep(sleep);
+/*
+	Renders the whole song to a video file as fast as possible
+	The analysis is done in this thread as every frame must get exactly its own part of the music
+	The sound system must use OUTPUT_WAVWRITER_NRT so FMOD writes the music to a WAV file at the same time
+	Every frame takes exactly 1 / FPS seconds of the mixed music so the video and the music stay in sync
+*/
+void visualizer_c::export_video(const char *file_name) {
+	video_exporter_c exporter(display.get_screen_framebuffer(), display.get_width(), display.get_height(), file_name);
+	if(!exporter.is_open()) {
+		std::cerr << "Couldn't open " << file_name << " for writing!" << std::endl;
+		return;
 	}
 
-	#if BAR_TYPE == 1
-		delete [] bar_start;
-		delete [] bar_end;
-		delete [] bar_first;
-		delete [] bar_first_mult;
-		delete [] bar_last;
-		delete [] bar_last_mult;
-	#endif
+	const unsigned int samples_per_frame = OUTPUTRATE / FPS;
+	const double start_time = get_time();
+	int frames = 0;
+	allocation_checker_c allocation_checker;
+
+	//Every update mixes one more block of the music
+	sound_system.play_music();
+	while(sound_system.is_playing() && display.is_open()) {
+		{
+			scoped_timer_c timer(STAGE_SOUND_UPDATE);
+			sound_system.update();
+		}
+		while(sound_system.get_available_samples() >= samples_per_frame) {
+			scoped_timer_c frame_timer(STAGE_FRAME);
+			analyzer.analyze(sound_system, samples_per_frame);
+			exported_analysis.capture(analyzer, sound_system);
+			{
+				scoped_timer_c timer(STAGE_PIPELINE_WAIT);
+				pipeline.begin_frame();
+			}
+			prepare_frame(exported_analysis);
+			submit_frame();
+			exporter.capture();
+			pipeline.end_frame();
+			frames++;
+			frame_timer.stop();
+			profiler.end_frame();
+			allocation_checker.end_frame();
+		}
+	}
+	exporter.finish();
+
+	const double seconds = get_time() - start_time;
+	std::cout << "Exported " << frames << " frames (" << frames / FPS << " seconds) in " << seconds << " seconds" << std::endl;
+	if(seconds > 0.0) std::cout << "  " << frames / seconds << " frames per second, " << frames / FPS / seconds << " times realtime" << std::endl;
+	print_state_changes(frames);
+	print_pipeline_waits(frames);
+	profiler.print();
+	print_bottleneck();
 }
@@ -3,8 +3,18 @@
 #ifndef VISUALIZER_HPP
 #define VISUALIZER_HPP
 
+#include "main.hpp"
 #include "graphics.hpp"
+#include "display.hpp"
 #include "sound_system.hpp"
+#include "analyzer.hpp"
+#include "gpu_bars.hpp"
+#include "frame_pipeline.hpp"
+#include "analysis_thread.hpp"
+#include "analysis_history.hpp"
+#include "frame_pacer.hpp"
+#include "hitch_recorder.hpp"
+#include "metrics_server.hpp"
 
 /*
 	This class is sort of the main loop of the program
@@ -15,12 +25,55 @@ class visualizer_c {
 		visualizer_c(const visualizer_c &obj); //Copy constructor
 		visualizer_c &operator=(const visualizer_c &obj); //Assign operator
 
+		display_c &display;
 		graphics_c graphics;
 		sound_system_c sound_system;
+		analyzer_c analyzer;
+		analysis_cache_c *cache;
+		gpu_bars_c *gpu_bars; //NULL when the bars are calculated on the CPU
+		render_queue_c render_queue;
+		frame_pipeline_c pipeline;
+		frame_pacer_c pacer;
+		analysis_thread_c analysis_thread; //Only used when playing in realtime
+		hitch_recorder_c hitch_recorder; //Only records when playing in realtime
+		metrics_server_c metrics_server; //Only serves when playing in realtime
+		analysis_history_c analysis_history; //The latest results of the thread
+		analysis_frame drawn_analysis; //The results for the moment the frame is shown
+
+		//The latency compensation
+		double prepare_time; //When the latest frame was prepared
+		double display_latency; //Seconds from preparing a frame to showing it
+		double av_latency; //How much later the latest prepared frame is shown than its sound is heard
+		double av_latency_sum; //The same for all the frames
+		int av_latency_frames;
+		analysis_frame exported_analysis; //The results of the analysis when exporting
+
+		//Everything that submit_frame needs to draw a frame after prepare_frame has written it
+		//The previous frame is kept for the motion blur of the squares
+		struct frame_state {
+			float bass_sum, left_sum, right_sum;
+			draw_batch bar_batch, bg_batch, square_batch;
+		};
+		frame_state frames[2];
+		int current_frame; //The prepared frame
+
+		void prepare_frame(const analysis_frame &analysis);
+		void submit_frame();
+		void prepare_next_frame();
+		void print_state_changes(const int frames) const;
+		void print_pipeline_waits(const int frames) const;
+		void print_latency() const;
+		void print_bottleneck() const;
 
 	public:
-		visualizer_c(const char *song_name);
-		void run();
+		visualizer_c(display_c &display, const char *song_name, const bool use_cache, const analyzer_settings &settings, const sound_output output = OUTPUT_DEVICE, const char *wav_name = NULL, const int frames_in_flight = FRAMES_IN_FLIGHT, const double fps = FPS);
+		~visualizer_c();
+		void run(const int frame_limit = 0, const char *screenshot_name = NULL);
+		void export_video(const char *file_name);
+		void record_hitches(const char *directory, const double threshold);
+		bool serve_metrics(const char *path);
+		int get_song_frames() const;
+		double get_av_latency() const;
 };
 
 #endif